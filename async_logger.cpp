@@ -0,0 +1,220 @@
+#include "async_logger.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <unistd.h>
+
+namespace {
+
+std::atomic<uint64_t> next_logger_id{1};
+
+/// Ring of one logger, as cached by a thread
+struct cached_ring {
+    uint64_t logger_id = 0;
+    signal_ring<log_record>* ring = nullptr;
+};
+
+/// The calling thread's rings, replaced round-robin when all are in use
+struct ring_cache {
+    cached_ring entries[async_logger::ring_cache_size];
+    size_t next_victim = 0;
+};
+
+thread_local ring_cache thread_rings;
+
+const char* level_name(log_level level) {
+    switch (level) {
+    case log_level::debug:
+        return "DEBUG";
+    case log_level::info:
+        return "INFO";
+    case log_level::warn:
+        return "WARN";
+    case log_level::error:
+        return "ERROR";
+    }
+    return "?";
+}
+
+void append_arg(const log_arg& arg, std::string& out) {
+    char buffer[32];
+    int length = 0;
+    switch (arg.kind) {
+    case log_arg::signed_int:
+        length = std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(arg.i));
+        break;
+    case log_arg::unsigned_int:
+        length = std::snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(arg.u));
+        break;
+    case log_arg::floating:
+        length = std::snprintf(buffer, sizeof(buffer), "%g", arg.d);
+        break;
+    case log_arg::text:
+        out += arg.s;
+        return;
+    case log_arg::none:
+        return;
+    }
+    out.append(buffer, static_cast<size_t>(length));
+}
+
+} // namespace
+
+async_logger::async_logger(int fd) : async_logger(fd, options()) {}
+
+async_logger::async_logger(int fd, const options& opts)
+    : fd(fd), opts(opts), min_level(opts.min_level), id(next_logger_id.fetch_add(1, std::memory_order_relaxed)) {
+    writer = std::thread(&async_logger::run, this);
+}
+
+async_logger::~async_logger() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake.notify_all();
+    writer.join();
+}
+
+void async_logger::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    const uint64_t generation = ++flush_requested;
+    wake.notify_all();
+    flushed.wait(lock, [this, generation]() { return flush_done >= generation; });
+}
+
+uint64_t async_logger::dropped() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    uint64_t total = 0;
+    for (const auto& r : rings) {
+        total += r->ring.dropped();
+    }
+    return total;
+}
+
+signal_ring<log_record>& async_logger::local_ring() {
+    ring_cache& cache = thread_rings;
+    for (const cached_ring& entry : cache.entries) {
+        if (entry.logger_id == id) {
+            return *entry.ring;
+        }
+    }
+    signal_ring<log_record>& ring = register_thread().ring;
+    // A signal handler may run between these stores: retire the entry
+    // before changing its ring so the handler never pairs an id with the
+    // wrong ring.
+    cached_ring& entry = cache.entries[cache.next_victim];
+    cache.next_victim = (cache.next_victim + 1) % ring_cache_size;
+    entry.logger_id = 0;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    entry.ring = &ring;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    entry.logger_id = id;
+    return ring;
+}
+
+async_logger::thread_ring& async_logger::register_thread() {
+    const std::thread::id self = std::this_thread::get_id();
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& r : rings) {
+        if (r->owner == self) {
+            return *r;
+        }
+    }
+    rings.push_back(std::unique_ptr<thread_ring>(new thread_ring(opts.ring_capacity)));
+    thread_ring& created = *rings.back();
+    created.owner = self;
+    created.index = rings.size() - 1;
+    ring_count.store(rings.size(), std::memory_order_release);
+    return created;
+}
+
+void async_logger::run() {
+    std::vector<thread_ring*> snapshot;
+    std::string batch;
+    batch.reserve(opts.write_batch + 1024);
+    for (;;) {
+        uint64_t generation;
+        bool stopping;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            generation = flush_requested;
+            stopping = !running;
+            if (snapshot.size() != rings.size()) {
+                snapshot.clear();
+                for (const auto& r : rings) {
+                    snapshot.push_back(r.get());
+                }
+            }
+        }
+
+        bool found = false;
+        while (drain(snapshot, batch)) {
+            found = true;
+        }
+        write_out(batch);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (flush_done != generation) {
+            flush_done = generation;
+            flushed.notify_all();
+        }
+        if (stopping) {
+            return;
+        }
+        if (!found && ring_count.load(std::memory_order_acquire) == snapshot.size()) {
+            wake.wait_for(lock, opts.poll_interval,
+                          [this, generation]() { return !running || flush_requested != generation; });
+        }
+    }
+}
+
+bool async_logger::drain(const std::vector<thread_ring*>& snapshot, std::string& batch) {
+    bool found = false;
+    log_record record;
+    for (thread_ring* r : snapshot) {
+        while (r->ring.try_pop(record)) {
+            found = true;
+            format(record, r->index, batch);
+            if (batch.size() >= opts.write_batch) {
+                write_out(batch);
+            }
+        }
+    }
+    return found;
+}
+
+void async_logger::format(const log_record& record, size_t thread_index, std::string& out) const {
+    char header[80];
+    const int length = std::snprintf(header, sizeof(header), "%lld.%09lld %s [%zu] ",
+                                     static_cast<long long>(record.timestamp_ns / 1000000000),
+                                     static_cast<long long>(record.timestamp_ns % 1000000000),
+                                     level_name(record.level), thread_index);
+    out.append(header, static_cast<size_t>(length));
+
+    size_t next_arg = 0;
+    for (const char* p = record.format; *p != '\0'; ++p) {
+        if (p[0] == '{' && p[1] == '}' && next_arg < record.arg_count) {
+            append_arg(record.args[next_arg++], out);
+            ++p;
+        } else {
+            out += *p;
+        }
+    }
+    out += '\n';
+}
+
+void async_logger::write_out(std::string& batch) {
+    size_t written = 0;
+    while (written < batch.size()) {
+        const ssize_t n = ::write(fd, batch.data() + written, batch.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;  // Nowhere to report it; drop the batch rather than stall the writer
+        }
+        written += static_cast<size_t>(n);
+    }
+    batch.clear();
+}
@@ -0,0 +1,217 @@
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "signal_ring.h"
+
+/**
+ * @brief Severity of a log record.
+ */
+enum class log_level : uint8_t { debug, info, warn, error };
+
+/**
+ * @brief One argument of a log record, captured in binary form.
+ *
+ * Strings are copied (truncated to text_size - 1 characters) so the caller's
+ * buffer may change as soon as log() returns.
+ */
+struct log_arg {
+    enum kind_t : uint8_t { none, signed_int, unsigned_int, floating, text };
+    static constexpr size_t text_size = 24;
+
+    kind_t kind;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        char s[text_size];
+    };
+};
+
+/**
+ * @brief A log call as stored in a thread's ring; formatted later by the writer thread.
+ */
+struct log_record {
+    static constexpr size_t max_args = 6;
+
+    int64_t timestamp_ns;       ///< system_clock nanoseconds since the epoch
+    const char* format;         ///< Must have static storage duration, e.g. a string literal
+    log_level level;
+    uint8_t arg_count;
+    log_arg args[max_args];
+};
+
+/**
+ * @brief Asynchronous logger: hot-path threads capture, a background thread formats and writes.
+ *
+ * log() stamps the call, copies its arguments into a fixed-size log_record
+ * and pushes it into a ring owned by the calling thread (a signal_ring with
+ * a single producer), taking no lock and making no syscall. The writer thread
+ * drains every thread's ring, expands the "{}" placeholders of the format
+ * string and hands the text to write() in batches of up to
+ * options::write_batch bytes, so the file is touched once per batch rather
+ * than once per line.
+ *
+ * A full ring drops the record (counted by dropped()) rather than stall the
+ * caller. Records of one thread are written in order; records of different
+ * threads are interleaved per drain pass, each line carrying its own
+ * timestamp.
+ *
+ * Each thread caches its rings for up to ring_cache_size loggers. log() is
+ * async-signal-safe for a logger whose ring is in the calling thread's
+ * cache, i.e. the thread has logged to it outside the handler and has not
+ * since logged to ring_cache_size other loggers; otherwise it registers the
+ * thread, which takes the logger's mutex.
+ */
+class async_logger {
+public:
+    /**
+     * @brief Tuning knobs.
+     */
+    struct options {
+        size_t ring_capacity = 4096;                    ///< Records buffered per thread
+        size_t write_batch = 64 * 1024;                 ///< Bytes formatted before each write()
+        std::chrono::milliseconds poll_interval{1};     ///< Writer sleep when all rings are empty
+        log_level min_level = log_level::debug;         ///< Records below this level are discarded
+    };
+
+    /**
+     * @brief Start a logger writing to @p fd (not owned, kept open by the caller).
+     */
+    explicit async_logger(int fd);
+
+    /**
+     * @brief Start a logger writing to @p fd with custom options.
+     */
+    async_logger(int fd, const options& opts);
+
+    /**
+     * @brief Write everything logged so far and stop the writer thread.
+     */
+    ~async_logger();
+
+    async_logger(const async_logger&) = delete;
+    async_logger& operator=(const async_logger&) = delete;
+
+    /**
+     * @brief Log a record; each "{}" in @p format is replaced by the next argument.
+     *
+     * @param format Format string with static storage duration.
+     * @param args Up to log_record::max_args integers, floating-point values or strings.
+     * @return bool false if the record was dropped because the thread's ring was full.
+     */
+    template <typename... Args>
+    bool log(log_level level, const char* format, const Args&... args) {
+        static_assert(sizeof...(Args) <= log_record::max_args, "too many log arguments");
+        if (level < min_level) {
+            return true;
+        }
+        log_record record;
+        record.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        record.format = format;
+        record.level = level;
+        record.arg_count = static_cast<uint8_t>(sizeof...(Args));
+        size_t index = 0;
+        (void)index;
+        (void)std::initializer_list<int>{(capture(record.args[index++], args), 0)...};
+        // The writer polls, so skip the ring's consumer wake-up
+        return local_ring().push_no_wake(record);
+    }
+
+    /**
+     * @brief Block until every record logged before the call has been written.
+     */
+    void flush();
+
+    /**
+     * @brief Get the number of records dropped because a ring was full.
+     */
+    uint64_t dropped() const;
+
+    /// Loggers whose rings each thread keeps cached
+    static constexpr size_t ring_cache_size = 8;
+
+private:
+    struct thread_ring {
+        explicit thread_ring(size_t capacity) : ring(capacity) {}
+
+        signal_ring<log_record> ring;
+        std::thread::id owner;
+        size_t index;               ///< Printed with each line to identify the thread
+    };
+
+    template <typename V>
+    static typename std::enable_if<std::is_integral<V>::value && std::is_signed<V>::value>::type
+    capture(log_arg& arg, V value) {
+        arg.kind = log_arg::signed_int;
+        arg.i = value;
+    }
+
+    template <typename V>
+    static typename std::enable_if<std::is_integral<V>::value && !std::is_signed<V>::value>::type
+    capture(log_arg& arg, V value) {
+        arg.kind = log_arg::unsigned_int;
+        arg.u = value;
+    }
+
+    template <typename V>
+    static typename std::enable_if<std::is_floating_point<V>::value>::type
+    capture(log_arg& arg, V value) {
+        arg.kind = log_arg::floating;
+        arg.d = static_cast<double>(value);
+    }
+
+    static void capture(log_arg& arg, const char* value) {
+        arg.kind = log_arg::text;
+        if (value == nullptr) {
+            value = "(null)";
+        }
+        std::strncpy(arg.s, value, log_arg::text_size - 1);
+        arg.s[log_arg::text_size - 1] = '\0';
+    }
+
+    static void capture(log_arg& arg, const std::string& value) { capture(arg, value.c_str()); }
+
+    /// The calling thread's ring, created on its first log() call
+    signal_ring<log_record>& local_ring();
+
+    thread_ring& register_thread();
+
+    void run();
+
+    /// Format every ready record into batch, writing whenever it fills; true if any was found
+    bool drain(const std::vector<thread_ring*>& snapshot, std::string& batch);
+
+    void format(const log_record& record, size_t thread_index, std::string& out) const;
+
+    void write_out(std::string& batch);
+
+    const int fd;
+    const options opts;
+    const log_level min_level;
+    const uint64_t id;                                  ///< Distinguishes loggers in thread-local caches
+    mutable std::mutex mutex;                           ///< Guards rings, running and the flush state
+    std::condition_variable wake;
+    std::condition_variable flushed;
+    std::vector<std::unique_ptr<thread_ring>> rings;
+    std::atomic<size_t> ring_count{0};                  ///< rings.size(), readable by the writer without the mutex
+    bool running = true;
+    uint64_t flush_requested = 0;                       ///< Generation of the latest flush() call
+    uint64_t flush_done = 0;                            ///< Generation completed by the writer
+    std::thread writer;
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "async_logger.h"
+
+namespace {
+
+class AsyncLoggerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char name[] = "/tmp/async_logger_testXXXXXX";
+        fd = ::mkstemp(name);
+        ASSERT_GE(fd, 0);
+        path = name;
+    }
+
+    void TearDown() override {
+        ::close(fd);
+        std::remove(path.c_str());
+    }
+
+    std::vector<std::string> lines() const {
+        std::ifstream in(path);
+        std::vector<std::string> result;
+        std::string line;
+        while (std::getline(in, line)) {
+            result.push_back(line);
+        }
+        return result;
+    }
+
+    /// Text after the "<timestamp> " prefix
+    static std::string body(const std::string& line) {
+        return line.substr(line.find(' ') + 1);
+    }
+
+    int fd = -1;
+    std::string path;
+};
+
+} // namespace
+
+TEST_F(AsyncLoggerTest, FormatsArgumentsOnTheWriterThread) {
+    async_logger logger(fd);
+    std::string name = "queue-a";
+    EXPECT_TRUE(logger.log(log_level::info, "{} depth={} ratio={} ok={}", name, -3, 0.5, 7u));
+    name = "overwritten";
+    logger.log(log_level::error, "no args {}");
+    logger.flush();
+
+    const auto written = lines();
+    ASSERT_EQ(written.size(), 2u);
+    EXPECT_EQ(body(written[0]), "INFO [0] queue-a depth=-3 ratio=0.5 ok=7");
+    EXPECT_EQ(body(written[1]), "ERROR [0] no args {}");
+}
+
+TEST_F(AsyncLoggerTest, MinLevelFiltersOnTheCallingThread) {
+    async_logger::options opts;
+    opts.min_level = log_level::warn;
+    {
+        async_logger logger(fd, opts);
+        logger.log(log_level::debug, "hidden");
+        logger.log(log_level::warn, "shown");
+    }
+    const auto written = lines();
+    ASSERT_EQ(written.size(), 1u);
+    EXPECT_EQ(body(written[0]), "WARN [0] shown");
+}
+
+TEST_F(AsyncLoggerTest, KeepsPerThreadOrder) {
+    const int threads = 4;
+    const int per_thread = 2000;
+    async_logger::options opts;
+    opts.ring_capacity = 8192;
+    async_logger logger(fd, opts);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&logger, t]() {
+            for (int i = 0; i < per_thread; ++i) {
+                logger.log(log_level::info, "t={} i={}", t, i);
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    logger.flush();
+    EXPECT_EQ(logger.dropped(), 0u);
+
+    std::vector<int> next(threads, 0);
+    const auto written = lines();
+    ASSERT_EQ(written.size(), static_cast<size_t>(threads * per_thread));
+    for (const auto& line : written) {
+        int t = -1;
+        int i = -1;
+        ASSERT_EQ(std::sscanf(line.c_str() + line.find("t="), "t=%d i=%d", &t, &i), 2);
+        EXPECT_EQ(i, next[t]++);
+    }
+}
+
+TEST_F(AsyncLoggerTest, ThreadKeepsRingsOfSeveralLoggers) {
+    async_logger first(fd);
+    async_logger second(fd);
+    first.log(log_level::info, "a");
+    second.log(log_level::info, "b");
+    first.log(log_level::info, "c");
+    first.flush();
+    second.flush();
+    EXPECT_EQ(lines().size(), 3u);
+    EXPECT_EQ(first.dropped(), 0u);
+}
@@ -0,0 +1,114 @@
+#ifndef BATCHING_PRODUCER_H
+#define BATCHING_PRODUCER_H
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+#include "enqueue.h"
+#include "queue_clock.h"
+
+/**
+ * @brief Producer-side buffer that hands items to a safe_queue in batches.
+ *
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy of the queue, also used for the linger time.
+ *
+ * Each push() into a safe_queue takes its mutex and may wake a consumer. A
+ * batching_producer collects items in a private buffer and moves them with
+ * one push_batch() when the buffer holds batch_size items or the oldest
+ * buffered item has lingered for linger (Nagle-style), cutting lock
+ * acquisitions and wake-ups by up to batch_size at the cost of a bounded
+ * delay before consumers see an item.
+ *
+ * A producer belongs to one thread; give each producer thread its own. There
+ * is no timer: the linger deadline is checked by push() and poll(), so an
+ * idle producer should call poll() (or flush()) periodically. The destructor
+ * flushes whatever is left.
+ */
+template <typename T, typename Clock = steady_clock_policy>
+class batching_producer {
+public:
+    /**
+     * @brief Construct a producer feeding @p queue.
+     *
+     * @param queue The queue to feed; must outlive the producer.
+     * @param batch_size Flush once this many items are buffered.
+     * @param linger Flush once the oldest buffered item is this old; zero
+     *        flushes only on a full buffer or explicitly.
+     */
+    batching_producer(safe_queue<T, Clock>& queue, size_t batch_size, std::chrono::milliseconds linger)
+        : target(queue), batch_size(batch_size > 0 ? batch_size : 1), linger(linger) {
+        buffer.reserve(this->batch_size);
+    }
+
+    /**
+     * @brief Flush the remaining items.
+     *
+     * Like flush(), this blocks while the queue is full. Close the queue
+     * before destroying a producer whose consumers have stopped, or the
+     * destructor (including during stack unwinding) waits forever; on a
+     * closed queue the remaining items are dropped.
+     */
+    ~batching_producer() { flush(); }
+
+    batching_producer(const batching_producer&) = delete;
+    batching_producer& operator=(const batching_producer&) = delete;
+
+    /**
+     * @brief Buffer an item, flushing if the buffer is full or has lingered.
+     *
+     * @return size_t The number of items dropped because the queue was closed
+     *         during a flush (0 normally).
+     */
+    size_t push(const T& item) {
+        if (buffer.empty()) {
+            oldest = Clock::now();
+        }
+        buffer.push_back(item);
+        if (buffer.size() >= batch_size) {
+            return flush();
+        }
+        return poll();
+    }
+
+    /**
+     * @brief Flush if the oldest buffered item has lingered long enough.
+     *
+     * @return size_t The number of items dropped because the queue was closed.
+     */
+    size_t poll() {
+        if (buffer.empty() || linger.count() == 0 || Clock::now() - oldest < linger) {
+            return 0;
+        }
+        return flush();
+    }
+
+    /**
+     * @brief Push every buffered item to the queue, blocking while it is full.
+     *
+     * @return size_t The number of items dropped because the queue was closed.
+     */
+    size_t flush() {
+        if (buffer.empty()) {
+            return 0;
+        }
+        const size_t pushed = target.push_batch(buffer.data(), buffer.size());
+        const size_t dropped = buffer.size() - pushed;
+        buffer.clear();
+        return dropped;
+    }
+
+    /**
+     * @brief Get the number of items buffered but not yet flushed.
+     */
+    size_t pending() const { return buffer.size(); }
+
+private:
+    safe_queue<T, Clock>& target;               ///< Queue receiving the batches
+    const size_t batch_size;                    ///< Items per full batch
+    const std::chrono::milliseconds linger;     ///< Maximum age of a buffered item, zero for none
+    std::vector<T> buffer;                      ///< Items not yet flushed
+    typename Clock::time_point oldest{};        ///< When the first buffered item arrived
+};
+
+#endif
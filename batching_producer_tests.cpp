@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include "batching_producer.h"
+
+using std::chrono::milliseconds;
+
+class BatchingProducerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        virtual_clock::reset();
+    }
+
+    void TearDown() override {
+        virtual_clock::reset();
+    }
+
+    safe_queue<int, virtual_clock> q{16};
+};
+
+TEST_F(BatchingProducerTest, FlushesWhenBatchFills) {
+    batching_producer<int, virtual_clock> producer(q, 3, milliseconds(0));
+    producer.push(1);
+    producer.push(2);
+    EXPECT_EQ(q.counters().depth.load(), 0u);
+    EXPECT_EQ(producer.pending(), 2u);
+
+    producer.push(3);
+    EXPECT_EQ(producer.pending(), 0u);
+    EXPECT_EQ(q.counters().depth.load(), 3u);
+    for (int expected = 1; expected <= 3; ++expected) {
+        EXPECT_EQ(q.pop(), expected);
+    }
+}
+
+TEST_F(BatchingProducerTest, FlushesAfterLinger) {
+    batching_producer<int, virtual_clock> producer(q, 100, milliseconds(10));
+    producer.push(1);
+    EXPECT_EQ(producer.poll(), 0u);
+    EXPECT_EQ(producer.pending(), 1u);
+
+    virtual_clock::advance(milliseconds(10));
+    producer.poll();
+    EXPECT_EQ(producer.pending(), 0u);
+    EXPECT_EQ(q.pop(), 1);
+}
+
+TEST_F(BatchingProducerTest, DestructorFlushes) {
+    {
+        batching_producer<int, virtual_clock> producer(q, 100, milliseconds(0));
+        producer.push(7);
+        producer.push(8);
+    }
+    EXPECT_EQ(q.pop(), 7);
+    EXPECT_EQ(q.pop(), 8);
+}
+
+TEST_F(BatchingProducerTest, FlushReportsItemsDroppedByClose) {
+    batching_producer<int, virtual_clock> producer(q, 100, milliseconds(0));
+    producer.push(1);
+    q.close();
+    EXPECT_EQ(producer.flush(), 1u);
+    EXPECT_EQ(producer.pending(), 0u);
+}
+
+TEST(PushBatchTest, BlocksForRoomAndKeepsOrder) {
+    safe_queue<int> q(2);
+    const int items[] = {1, 2, 3, 4, 5};
+    std::thread producer([&]() { EXPECT_EQ(q.push_batch(items, 5), 5u); });
+
+    for (int expected = 1; expected <= 5; ++expected) {
+        EXPECT_EQ(q.pop(), expected);
+    }
+    producer.join();
+    EXPECT_EQ(q.counters().pushes.load(), 5u);
+}
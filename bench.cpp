@@ -0,0 +1,614 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <thread>
+
+#include <sched.h>
+#include <sys/resource.h>
+
+#include "enqueue.h"
+#include "queue.h"
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+/**
+ * @brief Item pushed through the queue under test.
+ */
+struct bench_message {
+    bench_clock::time_point sent;   ///< When the producer pushed the item
+    std::string payload;            ///< Copied along with the item to model its size
+    bool stop = false;              ///< Tells a consumer to exit
+};
+
+/**
+ * @brief safe_queue constructed with a fixed pop order, for the ordered variants.
+ */
+template <queue_order Order>
+struct ordered_safe_queue : safe_queue<bench_message> {
+    explicit ordered_safe_queue(size_t capacity) : safe_queue<bench_message>(capacity, Order) {}
+};
+
+double seconds_of(const timeval& tv) {
+    return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1e6;
+}
+
+/**
+ * @brief Process-wide measurements taken around one run.
+ *
+ * Must be constructed before the worker threads so that they inherit the
+ * performance counters. The counters run only from start(), called as the
+ * workers are released, to stop(), called once they have been joined, so
+ * thread creation and the wait for the start flag are excluded; the drain
+ * and shutdown at the end of a run are included.
+ */
+class run_meter {
+public:
+    explicit run_meter(bool collect_counters) {
+        if (collect_counters) {
+            counters = std::make_unique<perf_counters>();
+        }
+    }
+
+    void start() {
+        if (counters) {
+            counters->start();
+            counters_before = counters->read();
+        }
+        getrusage(RUSAGE_SELF, &usage_before);
+        started = bench_clock::now();
+    }
+
+    void stop() {
+        finished = bench_clock::now();
+        getrusage(RUSAGE_SELF, &usage_after);
+        if (counters) {
+            counters->stop();
+            counters_after = counters->read();
+        }
+    }
+
+    /**
+     * @brief Build the result of the run from the per-consumer measurements.
+     */
+    bench_result result(const bench_config& config,
+                        const std::vector<latency_histogram>& histograms,
+                        const std::vector<uint64_t>& delivered) const {
+        latency_histogram latency;
+        bench_result result;
+        result.config = config;
+        for (size_t c = 0; c < histograms.size(); ++c) {
+            latency.merge(histograms[c]);
+            result.items += delivered[c];
+        }
+        result.seconds = std::chrono::duration<double>(finished - started).count();
+        result.throughput = result.seconds > 0.0 ? static_cast<double>(result.items) / result.seconds : 0.0;
+        result.latency_p50_ns = latency.percentile(0.50);
+        result.latency_p90_ns = latency.percentile(0.90);
+        result.latency_p99_ns = latency.percentile(0.99);
+        result.latency_p999_ns = latency.percentile(0.999);
+        result.latency_max_ns = latency.max();
+        result.cpu_user_seconds = seconds_of(usage_after.ru_utime) - seconds_of(usage_before.ru_utime);
+        result.cpu_system_seconds = seconds_of(usage_after.ru_stime) - seconds_of(usage_before.ru_stime);
+        if (result.seconds > 0.0) {
+            result.cpu_percent = 100.0 * (result.cpu_user_seconds + result.cpu_system_seconds) / result.seconds;
+        }
+        result.counters = counters_after - counters_before;
+        return result;
+    }
+
+private:
+    std::unique_ptr<perf_counters> counters;
+    perf_counters::sample counters_before;
+    perf_counters::sample counters_after;
+    rusage usage_before{};
+    rusage usage_after{};
+    bench_clock::time_point started;
+    bench_clock::time_point finished;
+};
+
+/**
+ * @brief Block until the start flag is raised.
+ */
+void wait_for_go(const std::atomic<bool>& go) {
+    while (!go.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * @brief Record the push-to-pop latency of a delivered item.
+ */
+void record_latency(latency_histogram& histogram, const bench_message& message) {
+    auto latency = bench_clock::now() - message.sent;
+    histogram.record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count()));
+}
+
+/**
+ * @brief Print the mutex profile of a queue to stderr, if it keeps one.
+ */
+template <typename Queue>
+void report_lock_profile(const Queue&) {}
+
+#ifdef SAFE_QUEUE_LOCK_PROFILING
+template <typename T, typename Clock>
+void report_lock_profile(const safe_queue<T, Clock>& queue) {
+    print_lock_profile(std::cerr, queue.lock_stats());
+}
+#endif
+
+/**
+ * @brief Run the scenario against a concrete queue type.
+ *
+ * @tparam Queue A queue with the safe_queue push/pop interface.
+ */
+template <typename Queue>
+bench_result run_on(const bench_config& config) {
+    Queue queue(config.capacity);
+    run_meter meter(config.counters);
+    std::atomic<bool> go(false);
+    std::vector<latency_histogram> histograms(config.consumers);
+    std::vector<uint64_t> delivered(config.consumers, 0);
+    const std::string payload(config.payload_size, 'x');
+
+    std::vector<std::thread> consumers;
+    for (size_t c = 0; c < config.consumers; ++c) {
+        consumers.emplace_back([&, c]() {
+            if (config.pin) {
+                pin_current_thread(config.producers + c);
+            }
+            wait_for_go(go);
+            for (;;) {
+                bench_message message = queue.pop();
+                if (message.stop) {
+                    break;
+                }
+                record_latency(histograms[c], message);
+                ++delivered[c];
+            }
+        });
+    }
+
+    // Each producer paces itself to an equal share of the target rate
+    bench_clock::duration interval = bench_clock::duration::zero();
+    if (config.rate > 0.0) {
+        interval = std::chrono::duration_cast<bench_clock::duration>(
+            std::chrono::duration<double>(static_cast<double>(config.producers) / config.rate));
+    }
+
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < config.producers; ++p) {
+        producers.emplace_back([&, p]() {
+            if (config.pin) {
+                pin_current_thread(p);
+            }
+            wait_for_go(go);
+            auto start = bench_clock::now();
+            auto deadline = start + config.duration;
+            auto next_send = start;
+            bench_message message;
+            message.payload = payload;
+            for (;;) {
+                auto now = bench_clock::now();
+                if (now >= deadline) {
+                    break;
+                }
+                if (interval != bench_clock::duration::zero()) {
+                    if (now < next_send) {
+                        std::this_thread::sleep_until(std::min(next_send, deadline));
+                        continue;
+                    }
+                    next_send += interval;
+                }
+                message.sent = bench_clock::now();
+                queue.push(message);
+            }
+        });
+    }
+
+    meter.start();
+    go.store(true, std::memory_order_release);
+
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    // Drain before stopping: a LIFO queue would serve the stop messages first
+    while (queue.size() > 0) {
+        std::this_thread::yield();
+    }
+    bench_message stop;
+    stop.stop = true;
+    for (size_t c = 0; c < config.consumers; ++c) {
+        queue.push(stop);
+    }
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+
+    meter.stop();
+    report_lock_profile(queue);
+    return meter.result(config, histograms, delivered);
+}
+
+/**
+ * @brief Replay recorded per-thread push and pop times against a concrete queue type.
+ *
+ * @tparam Queue A queue with the safe_queue push/pop interface.
+ */
+template <typename Queue>
+bench_result replay_on(const bench_config& config, const replay_schedule& schedule, double speed) {
+    Queue queue(config.capacity);
+    run_meter meter(config.counters);
+    std::atomic<bool> go(false);
+    std::vector<latency_histogram> histograms(schedule.consumers.size());
+    std::vector<uint64_t> delivered(schedule.consumers.size(), 0);
+    const std::string payload(config.payload_size, 'x');
+    bench_clock::time_point start;
+
+    auto due = [&start, speed](uint64_t offset_ns) {
+        return start + std::chrono::duration_cast<bench_clock::duration>(
+            std::chrono::duration<double, std::nano>(static_cast<double>(offset_ns) / speed));
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t c = 0; c < schedule.consumers.size(); ++c) {
+        threads.emplace_back([&, c]() {
+            if (config.pin) {
+                pin_current_thread(schedule.producers.size() + c);
+            }
+            wait_for_go(go);
+            for (uint64_t offset : schedule.consumers[c]) {
+                std::this_thread::sleep_until(due(offset));
+                bench_message message = queue.pop();
+                record_latency(histograms[c], message);
+                ++delivered[c];
+            }
+        });
+    }
+    for (size_t p = 0; p < schedule.producers.size(); ++p) {
+        threads.emplace_back([&, p]() {
+            if (config.pin) {
+                pin_current_thread(p);
+            }
+            wait_for_go(go);
+            bench_message message;
+            message.payload = payload;
+            for (uint64_t offset : schedule.producers[p]) {
+                std::this_thread::sleep_until(due(offset));
+                message.sent = bench_clock::now();
+                queue.push(message);
+            }
+        });
+    }
+
+    meter.start();
+    start = bench_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    meter.stop();
+    report_lock_profile(queue);
+    return meter.result(config, histograms, delivered);
+}
+
+} // namespace
+
+const std::vector<queue_variant>& all_variants() {
+    static const std::vector<queue_variant> variants = {
+        queue_variant::safe_queue,
+        queue_variant::thread_safe_queue,
+        queue_variant::safe_queue_lifo,
+        queue_variant::safe_queue_hybrid,
+    };
+    return variants;
+}
+
+const char* variant_name(queue_variant variant) {
+    switch (variant) {
+    case queue_variant::safe_queue:
+        return "safe_queue";
+    case queue_variant::thread_safe_queue:
+        return "thread_safe_queue";
+    case queue_variant::safe_queue_lifo:
+        return "safe_queue_lifo";
+    case queue_variant::safe_queue_hybrid:
+        return "safe_queue_hybrid";
+    }
+    return "unknown";
+}
+
+bool parse_variant(const std::string& name, queue_variant& variant) {
+    for (auto candidate : all_variants()) {
+        if (name == variant_name(candidate)) {
+            variant = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t latency_histogram::bucket_of(uint64_t ns) {
+    if (ns < sub_buckets) {
+        return static_cast<size_t>(ns);
+    }
+    // Position of the highest set bit selects the power of two, the next four
+    // bits select the linear sub-bucket within it
+    size_t magnitude = 63 - static_cast<size_t>(__builtin_clzll(ns));
+    size_t sub = static_cast<size_t>(ns >> (magnitude - 4)) & (sub_buckets - 1);
+    return (magnitude - 3) * sub_buckets + sub;
+}
+
+uint64_t latency_histogram::bucket_upper(size_t bucket) {
+    if (bucket < sub_buckets) {
+        return bucket;
+    }
+    size_t magnitude = bucket / sub_buckets + 3;
+    uint64_t sub = bucket % sub_buckets;
+    return ((sub_buckets + sub + 1) << (magnitude - 4)) - 1;
+}
+
+void latency_histogram::record(uint64_t ns) {
+    ++counts[bucket_of(ns)];
+    ++total;
+    maximum = std::max(maximum, ns);
+}
+
+void latency_histogram::merge(const latency_histogram& other) {
+    for (size_t i = 0; i < bucket_count; ++i) {
+        counts[i] += other.counts[i];
+    }
+    total += other.total;
+    maximum = std::max(maximum, other.maximum);
+}
+
+uint64_t latency_histogram::percentile(double q) const {
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucket_count; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(bucket_upper(i), maximum);
+        }
+    }
+    return maximum;
+}
+
+bench_result run_bench(const bench_config& config) {
+    switch (config.variant) {
+    case queue_variant::thread_safe_queue:
+        return run_on<ThreadSafeQueue<bench_message>>(config);
+    case queue_variant::safe_queue_lifo:
+        return run_on<ordered_safe_queue<queue_order::lifo>>(config);
+    case queue_variant::safe_queue_hybrid:
+        return run_on<ordered_safe_queue<queue_order::hybrid>>(config);
+    case queue_variant::safe_queue:
+    default:
+        return run_on<safe_queue<bench_message>>(config);
+    }
+}
+
+std::vector<size_t> sweep_thread_counts(size_t max_threads) {
+    std::vector<size_t> counts;
+    for (size_t n = 1; n < max_threads; n *= 2) {
+        counts.push_back(n);
+    }
+    counts.push_back(std::max<size_t>(max_threads, 1));
+    return counts;
+}
+
+std::vector<bench_result> run_sweep(const bench_config& base,
+                                    const std::vector<queue_variant>& variants,
+                                    size_t max_threads,
+                                    std::ostream* progress) {
+    std::vector<bench_result> results;
+    const std::vector<size_t> counts = sweep_thread_counts(max_threads);
+    for (queue_variant variant : variants) {
+        for (size_t producers : counts) {
+            for (size_t consumers : counts) {
+                bench_config config = base;
+                config.variant = variant;
+                config.producers = producers;
+                config.consumers = consumers;
+                config.pin = true;
+                results.push_back(run_bench(config));
+                if (progress != nullptr) {
+                    *progress << variant_name(variant) << " " << producers << "x" << consumers
+                              << ": " << results.back().throughput << " items/s" << std::endl;
+                }
+            }
+        }
+    }
+    return results;
+}
+
+replay_schedule make_replay_schedule(const std::vector<trace_event>& events, uint32_t queue_id) {
+    replay_schedule schedule;
+    std::map<uint16_t, size_t> producer_index;
+    std::map<uint16_t, size_t> consumer_index;
+    uint64_t base = 0;
+    bool have_base = false;
+    size_t pushes = 0;
+    size_t pops = 0;
+
+    for (const trace_event& event : events) {
+        if (event.queue_id != queue_id) {
+            continue;
+        }
+        if (!have_base) {
+            base = event.timestamp_ns;
+            have_base = true;
+        }
+        bool is_push = event.op == static_cast<uint8_t>(trace_op::push);
+        auto& index = is_push ? producer_index : consumer_index;
+        auto& threads = is_push ? schedule.producers : schedule.consumers;
+        auto found = index.find(event.thread_id);
+        if (found == index.end()) {
+            found = index.emplace(event.thread_id, threads.size()).first;
+            threads.emplace_back();
+        }
+        threads[found->second].push_back(event.timestamp_ns - base);
+        ++(is_push ? pushes : pops);
+        schedule.span_ns = event.timestamp_ns - base;
+    }
+
+    // Balance the schedule so the replay always drains: drop the earliest
+    // surplus pops (they took items pushed before tracing started), or let
+    // the last consumer collect leftover items at the end
+    while (pops > pushes) {
+        size_t earliest = 0;
+        for (size_t c = 1; c < schedule.consumers.size(); ++c) {
+            if (!schedule.consumers[c].empty() &&
+                (schedule.consumers[earliest].empty() ||
+                 schedule.consumers[c].front() < schedule.consumers[earliest].front())) {
+                earliest = c;
+            }
+        }
+        auto& offsets = schedule.consumers[earliest];
+        offsets.erase(offsets.begin());
+        --pops;
+    }
+    if (pushes > pops) {
+        if (schedule.consumers.empty()) {
+            schedule.consumers.emplace_back();
+        }
+        schedule.consumers.back().resize(schedule.consumers.back().size() + (pushes - pops), schedule.span_ns);
+    }
+    return schedule;
+}
+
+bench_result run_replay(const bench_config& config, const replay_schedule& schedule, double speed) {
+    bench_config replayed = config;
+    replayed.producers = schedule.producers.size();
+    replayed.consumers = schedule.consumers.size();
+    replayed.rate = 0.0;
+    replayed.duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::nanoseconds(schedule.span_ns));
+    if (speed <= 0.0) {
+        speed = 1.0;
+    }
+
+    switch (replayed.variant) {
+    case queue_variant::thread_safe_queue:
+        return replay_on<ThreadSafeQueue<bench_message>>(replayed, schedule, speed);
+    case queue_variant::safe_queue_lifo:
+        return replay_on<ordered_safe_queue<queue_order::lifo>>(replayed, schedule, speed);
+    case queue_variant::safe_queue_hybrid:
+        return replay_on<ordered_safe_queue<queue_order::hybrid>>(replayed, schedule, speed);
+    case queue_variant::safe_queue:
+    default:
+        return replay_on<safe_queue<bench_message>>(replayed, schedule, speed);
+    }
+}
+
+bool counter_per_million(const bench_result& result, perf_counters::counter which, double& value) {
+    if (!result.counters.available[which] || result.items == 0) {
+        return false;
+    }
+    value = static_cast<double>(result.counters.values[which]) * 1e6 / static_cast<double>(result.items);
+    return true;
+}
+
+bool pin_current_thread(size_t index) {
+    unsigned cpus = std::thread::hardware_concurrency();
+    if (cpus == 0) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(static_cast<int>(index % cpus), &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+void write_json(std::ostream& out, const std::vector<bench_result>& results) {
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const bench_result& r = results[i];
+        out << "  {"
+            << "\"queue\": \"" << variant_name(r.config.variant) << "\", "
+            << "\"producers\": " << r.config.producers << ", "
+            << "\"consumers\": " << r.config.consumers << ", "
+            << "\"capacity\": " << r.config.capacity << ", "
+            << "\"payload_size\": " << r.config.payload_size << ", "
+            << "\"rate\": " << r.config.rate << ", "
+            << "\"duration_ms\": " << r.config.duration.count() << ", "
+            << "\"pinned\": " << (r.config.pin ? "true" : "false") << ", "
+            << "\"items\": " << r.items << ", "
+            << "\"seconds\": " << r.seconds << ", "
+            << "\"throughput\": " << r.throughput << ", "
+            << "\"latency_ns\": {"
+            << "\"p50\": " << r.latency_p50_ns << ", "
+            << "\"p90\": " << r.latency_p90_ns << ", "
+            << "\"p99\": " << r.latency_p99_ns << ", "
+            << "\"p999\": " << r.latency_p999_ns << ", "
+            << "\"max\": " << r.latency_max_ns << "}, "
+            << "\"cpu\": {"
+            << "\"user_seconds\": " << r.cpu_user_seconds << ", "
+            << "\"system_seconds\": " << r.cpu_system_seconds << ", "
+            << "\"percent\": " << r.cpu_percent << "}, "
+            << "\"counters_per_million_items\": {";
+        for (size_t c = 0; c < perf_counters::counter_count; ++c) {
+            auto which = static_cast<perf_counters::counter>(c);
+            double value = 0.0;
+            out << (c ? ", " : "") << "\"" << perf_counters::name(which) << "\": ";
+            if (counter_per_million(r, which, value)) {
+                out << value;
+            } else {
+                out << "null";
+            }
+        }
+        out << "}"
+            << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+void write_csv(std::ostream& out, const std::vector<bench_result>& results) {
+    out << "queue,producers,consumers,capacity,payload_size,rate,duration_ms,pinned,"
+           "items,seconds,throughput,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,"
+           "cpu_user_s,cpu_system_s,cpu_percent";
+    for (size_t c = 0; c < perf_counters::counter_count; ++c) {
+        out << ',' << perf_counters::name(static_cast<perf_counters::counter>(c)) << "_per_mitem";
+    }
+    out << '\n';
+    for (const bench_result& r : results) {
+        out << variant_name(r.config.variant) << ','
+            << r.config.producers << ','
+            << r.config.consumers << ','
+            << r.config.capacity << ','
+            << r.config.payload_size << ','
+            << r.config.rate << ','
+            << r.config.duration.count() << ','
+            << (r.config.pin ? 1 : 0) << ','
+            << r.items << ','
+            << r.seconds << ','
+            << r.throughput << ','
+            << r.latency_p50_ns << ','
+            << r.latency_p90_ns << ','
+            << r.latency_p99_ns << ','
+            << r.latency_p999_ns << ','
+            << r.latency_max_ns << ','
+            << r.cpu_user_seconds << ','
+            << r.cpu_system_seconds << ','
+            << r.cpu_percent;
+        // Unavailable counters are left empty
+        for (size_t c = 0; c < perf_counters::counter_count; ++c) {
+            double value = 0.0;
+            out << ',';
+            if (counter_per_million(r, static_cast<perf_counters::counter>(c), value)) {
+                out << value;
+            }
+        }
+        out << '\n';
+    }
+}
@@ -0,0 +1,221 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "perf_counters.h"
+#include "queue_trace.h"
+
+/**
+ * @brief Queue implementations the load generator can drive.
+ */
+enum class queue_variant {
+    safe_queue,         ///< safe_queue from enqueue.h
+    thread_safe_queue,  ///< ThreadSafeQueue from queue.h
+    safe_queue_lifo,    ///< safe_queue serving the newest item (queue_order::lifo)
+    safe_queue_hybrid   ///< safe_queue serving LIFO until half full (queue_order::hybrid)
+};
+
+/**
+ * @brief Get every queue variant the load generator supports.
+ */
+const std::vector<queue_variant>& all_variants();
+
+/**
+ * @brief Get the command-line name of a queue variant.
+ */
+const char* variant_name(queue_variant variant);
+
+/**
+ * @brief Parse a queue variant from its command-line name.
+ *
+ * @param name The variant name (e.g. "safe_queue").
+ * @param variant Receives the parsed variant.
+ * @return true If @p name names a known variant.
+ */
+bool parse_variant(const std::string& name, queue_variant& variant);
+
+/**
+ * @brief Parameters of a single load-generator run.
+ */
+struct bench_config {
+    queue_variant variant = queue_variant::safe_queue;  ///< Queue implementation under test
+    size_t producers = 1;                               ///< Number of producer threads
+    size_t consumers = 1;                               ///< Number of consumer threads
+    size_t capacity = 1024;                             ///< Queue capacity in items
+    size_t payload_size = 0;                            ///< Bytes of payload copied with each item
+    double rate = 0.0;                                  ///< Target total rate in items/s (0 = unthrottled)
+    std::chrono::milliseconds duration{1000};           ///< How long producers generate load
+    bool pin = false;                                   ///< Pin each thread to its own CPU
+    bool counters = true;                               ///< Collect hardware performance counters
+};
+
+/**
+ * @brief Log-linear latency histogram with bounded memory.
+ *
+ * Values are bucketed by their power of two and then into 16 linear
+ * sub-buckets, so percentiles are accurate to within ~6%.
+ */
+class latency_histogram {
+public:
+    static constexpr size_t sub_buckets = 16;   ///< Linear sub-buckets per power of two
+    static constexpr size_t bucket_count = 64 * sub_buckets;
+
+    /**
+     * @brief Record one latency sample in nanoseconds.
+     */
+    void record(uint64_t ns);
+
+    /**
+     * @brief Add all samples of another histogram to this one.
+     */
+    void merge(const latency_histogram& other);
+
+    /**
+     * @brief Get the approximate value at quantile @p q (0.0 - 1.0).
+     *
+     * @return uint64_t The upper bound of the bucket holding the quantile, 0 if empty.
+     */
+    uint64_t percentile(double q) const;
+
+    uint64_t count() const { return total; }    ///< Number of recorded samples
+    uint64_t max() const { return maximum; }    ///< Largest recorded sample
+
+private:
+    static size_t bucket_of(uint64_t ns);
+    static uint64_t bucket_upper(size_t bucket);
+
+    std::array<uint64_t, bucket_count> counts{};
+    uint64_t total = 0;
+    uint64_t maximum = 0;
+};
+
+/**
+ * @brief Measurements of a single load-generator run.
+ */
+struct bench_result {
+    bench_config config;            ///< Parameters the run used
+    uint64_t items = 0;             ///< Items delivered to consumers
+    double seconds = 0.0;           ///< Wall-clock duration of the run
+    double throughput = 0.0;        ///< Delivered items per second
+    uint64_t latency_p50_ns = 0;    ///< Median push-to-pop latency
+    uint64_t latency_p90_ns = 0;    ///< 90th percentile push-to-pop latency
+    uint64_t latency_p99_ns = 0;    ///< 99th percentile push-to-pop latency
+    uint64_t latency_p999_ns = 0;   ///< 99.9th percentile push-to-pop latency
+    uint64_t latency_max_ns = 0;    ///< Worst push-to-pop latency
+    double cpu_user_seconds = 0.0;  ///< Process user CPU time during the run
+    double cpu_system_seconds = 0.0;///< Process system CPU time during the run
+    double cpu_percent = 0.0;       ///< CPU time as a percentage of one core's wall time
+    perf_counters::sample counters; ///< Counter deltas from the start flag until the workers were joined
+};
+
+/**
+ * @brief Get a performance counter normalized per million delivered items.
+ *
+ * @param result The run to read from.
+ * @param which The counter to normalize.
+ * @param value Receives the counter value per million items.
+ * @return true If the counter was available for the run.
+ */
+bool counter_per_million(const bench_result& result, perf_counters::counter which, double& value);
+
+/**
+ * @brief Run one load-generation scenario.
+ *
+ * Producers push timestamped items (paced to config.rate if set) for
+ * config.duration, then consumers drain the queue; latency is measured from
+ * push to pop.
+ *
+ * @param config The scenario to run.
+ * @return bench_result The measurements of the run.
+ */
+bench_result run_bench(const bench_config& config);
+
+/**
+ * @brief Per-thread operation times of one queue, extracted from a trace.
+ *
+ * Offsets are nanoseconds since the first traced event of the queue. Each
+ * recorded thread that pushed becomes a producer and each thread that popped
+ * becomes a consumer.
+ */
+struct replay_schedule {
+    std::vector<std::vector<uint64_t>> producers;   ///< Push arrival offsets per producer thread
+    std::vector<std::vector<uint64_t>> consumers;   ///< Pop completion offsets per consumer thread
+    uint64_t span_ns = 0;                           ///< Offset of the last event
+};
+
+/**
+ * @brief Extract the replay schedule of one queue from a trace.
+ *
+ * The pop count is balanced to the push count so that a replay always
+ * drains: surplus pops (items pushed before tracing started) are dropped and
+ * missing pops (items still queued when tracing stopped) are added at the end.
+ *
+ * @param events Trace events in timestamp order, as read by queue_trace::read().
+ * @param queue_id The queue whose events to extract.
+ * @return replay_schedule The arrival and service pattern of the queue.
+ */
+replay_schedule make_replay_schedule(const std::vector<trace_event>& events, uint32_t queue_id);
+
+/**
+ * @brief Replay a recorded arrival/service pattern against a queue variant.
+ *
+ * Producers push at their recorded offsets and consumers pop no earlier than
+ * theirs, both scaled by 1 / @p speed. Thread counts and duration in the
+ * result's config are taken from the schedule.
+ *
+ * @param config Queue variant, capacity, payload size, pinning and counters to use.
+ * @param schedule The pattern to reproduce.
+ * @param speed Time compression factor (2.0 replays twice as fast).
+ * @return bench_result The measurements of the replay.
+ */
+bench_result run_replay(const bench_config& config, const replay_schedule& schedule, double speed);
+
+/**
+ * @brief Get the thread counts visited by a scalability sweep.
+ *
+ * @param max_threads The largest thread count to include.
+ * @return std::vector<size_t> Powers of two below @p max_threads, followed by @p max_threads.
+ */
+std::vector<size_t> sweep_thread_counts(size_t max_threads);
+
+/**
+ * @brief Run a producers x consumers scalability sweep.
+ *
+ * Every variant is run for each combination of sweep_thread_counts(max_threads)
+ * producers and consumers, with threads pinned to distinct CPUs. All other
+ * parameters are taken from @p base.
+ *
+ * @param base The scenario parameters shared by all runs.
+ * @param variants The queue variants to sweep.
+ * @param max_threads The largest producer and consumer count.
+ * @param progress If not null, receives one line per completed run.
+ * @return std::vector<bench_result> One result per run, in sweep order.
+ */
+std::vector<bench_result> run_sweep(const bench_config& base,
+                                    const std::vector<queue_variant>& variants,
+                                    size_t max_threads,
+                                    std::ostream* progress);
+
+/**
+ * @brief Pin the calling thread to CPU @p index modulo the number of online CPUs.
+ *
+ * @return true If the affinity was applied.
+ */
+bool pin_current_thread(size_t index);
+
+/**
+ * @brief Write results as a JSON array.
+ */
+void write_json(std::ostream& out, const std::vector<bench_result>& results);
+
+/**
+ * @brief Write results as CSV, one row per result, preceded by a header row.
+ */
+void write_csv(std::ostream& out, const std::vector<bench_result>& results);
+
+#endif
@@ -0,0 +1,371 @@
+#include "bench_compare.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+/**
+ * @brief Minimal JSON document model, sufficient for the files write_json() produces.
+ */
+struct json_value {
+    enum class kind { null, boolean, number, string, array, object };
+
+    kind type = kind::null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<json_value> array;
+    std::vector<std::pair<std::string, json_value>> object;
+
+    /**
+     * @brief Look up an object member, returning a null value if absent.
+     */
+    const json_value& operator[](const std::string& key) const {
+        static const json_value missing;
+        for (const auto& member : object) {
+            if (member.first == key) {
+                return member.second;
+            }
+        }
+        return missing;
+    }
+};
+
+/**
+ * @brief Recursive-descent JSON parser.
+ */
+class json_parser {
+public:
+    explicit json_parser(const std::string& text) : text(text), pos(0) {}
+
+    bool parse(json_value& value, std::string& error) {
+        if (!parse_value(value) || (skip_space(), pos != text.size())) {
+            std::ostringstream message;
+            message << "malformed JSON at offset " << pos;
+            error = message.str();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    void skip_space() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+            ++pos;
+        }
+    }
+
+    bool consume(char expected) {
+        skip_space();
+        if (pos < text.size() && text[pos] == expected) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool consume_word(const char* word) {
+        size_t length = std::char_traits<char>::length(word);
+        if (text.compare(pos, length, word) == 0) {
+            pos += length;
+            return true;
+        }
+        return false;
+    }
+
+    bool parse_string(std::string& out) {
+        if (!consume('"')) {
+            return false;
+        }
+        while (pos < text.size() && text[pos] != '"') {
+            if (text[pos] == '\\' && pos + 1 < text.size()) {
+                ++pos;
+            }
+            out += text[pos++];
+        }
+        return consume('"');
+    }
+
+    bool parse_value(json_value& value) {
+        skip_space();
+        if (pos >= text.size()) {
+            return false;
+        }
+        char c = text[pos];
+        if (c == '{') {
+            ++pos;
+            value.type = json_value::kind::object;
+            if (consume('}')) {
+                return true;
+            }
+            do {
+                std::pair<std::string, json_value> member;
+                if (!parse_string(member.first) || !consume(':') || !parse_value(member.second)) {
+                    return false;
+                }
+                value.object.push_back(std::move(member));
+            } while (consume(','));
+            return consume('}');
+        }
+        if (c == '[') {
+            ++pos;
+            value.type = json_value::kind::array;
+            if (consume(']')) {
+                return true;
+            }
+            do {
+                value.array.emplace_back();
+                if (!parse_value(value.array.back())) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(']');
+        }
+        if (c == '"') {
+            value.type = json_value::kind::string;
+            return parse_string(value.string);
+        }
+        if (consume_word("true")) {
+            value.type = json_value::kind::boolean;
+            value.boolean = true;
+            return true;
+        }
+        if (consume_word("false")) {
+            value.type = json_value::kind::boolean;
+            return true;
+        }
+        if (consume_word("null")) {
+            return true;
+        }
+        const char* begin = text.c_str() + pos;
+        char* end = nullptr;
+        value.number = std::strtod(begin, &end);
+        if (end == begin) {
+            return false;
+        }
+        value.type = json_value::kind::number;
+        pos += static_cast<size_t>(end - begin);
+        return true;
+    }
+
+    const std::string& text;
+    size_t pos;
+};
+
+/**
+ * @brief Identify a scenario by every parameter that affects its results.
+ */
+std::string scenario_key(const bench_config& config) {
+    std::ostringstream key;
+    key << variant_name(config.variant)
+        << " p=" << config.producers
+        << " c=" << config.consumers
+        << " cap=" << config.capacity
+        << " payload=" << config.payload_size
+        << " rate=" << config.rate
+        << " dur=" << config.duration.count() << "ms"
+        << (config.pin ? " pinned" : "");
+    return key.str();
+}
+
+/**
+ * @brief Two-sided 95% critical value of Student's t distribution.
+ */
+double t_critical_95(double degrees_of_freedom) {
+    static const double table[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+    };
+    if (degrees_of_freedom < 1.0) {
+        return table[0];
+    }
+    if (degrees_of_freedom <= 30.0) {
+        return table[static_cast<size_t>(degrees_of_freedom) - 1];
+    }
+    if (degrees_of_freedom <= 60.0) {
+        return 2.000;
+    }
+    if (degrees_of_freedom <= 120.0) {
+        return 1.980;
+    }
+    return 1.960;
+}
+
+/**
+ * @brief Sample mean and variance of one metric.
+ */
+struct metric_stats {
+    size_t n = 0;
+    double mean = 0.0;
+    double variance = 0.0;
+};
+
+metric_stats stats_of(const std::vector<double>& samples) {
+    metric_stats stats;
+    stats.n = samples.size();
+    if (stats.n == 0) {
+        return stats;
+    }
+    for (double sample : samples) {
+        stats.mean += sample;
+    }
+    stats.mean /= static_cast<double>(stats.n);
+    if (stats.n > 1) {
+        for (double sample : samples) {
+            stats.variance += (sample - stats.mean) * (sample - stats.mean);
+        }
+        stats.variance /= static_cast<double>(stats.n - 1);
+    }
+    return stats;
+}
+
+/**
+ * @brief A compared metric and the direction in which it improves.
+ */
+struct metric {
+    const char* name;
+    double (*extract)(const bench_result&);
+    bool higher_is_better;
+};
+
+const metric compared_metrics[] = {
+    {"throughput", [](const bench_result& r) { return r.throughput; }, true},
+    {"p50_ns", [](const bench_result& r) { return static_cast<double>(r.latency_p50_ns); }, false},
+    {"p99_ns", [](const bench_result& r) { return static_cast<double>(r.latency_p99_ns); }, false},
+    {"p999_ns", [](const bench_result& r) { return static_cast<double>(r.latency_p999_ns); }, false},
+};
+
+} // namespace
+
+bool load_results(const std::string& path, std::vector<bench_result>& results, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    const std::string text = buffer.str();
+
+    json_value document;
+    if (!json_parser(text).parse(document, error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    if (document.type != json_value::kind::array) {
+        error = path + ": expected an array of results";
+        return false;
+    }
+
+    for (const json_value& entry : document.array) {
+        bench_result result;
+        if (!parse_variant(entry["queue"].string, result.config.variant)) {
+            error = path + ": unknown queue variant '" + entry["queue"].string + "'";
+            return false;
+        }
+        result.config.producers = static_cast<size_t>(entry["producers"].number);
+        result.config.consumers = static_cast<size_t>(entry["consumers"].number);
+        result.config.capacity = static_cast<size_t>(entry["capacity"].number);
+        result.config.payload_size = static_cast<size_t>(entry["payload_size"].number);
+        result.config.rate = entry["rate"].number;
+        result.config.duration = std::chrono::milliseconds(static_cast<long long>(entry["duration_ms"].number));
+        result.config.pin = entry["pinned"].boolean;
+        result.items = static_cast<uint64_t>(entry["items"].number);
+        result.seconds = entry["seconds"].number;
+        result.throughput = entry["throughput"].number;
+        const json_value& latency = entry["latency_ns"];
+        result.latency_p50_ns = static_cast<uint64_t>(latency["p50"].number);
+        result.latency_p90_ns = static_cast<uint64_t>(latency["p90"].number);
+        result.latency_p99_ns = static_cast<uint64_t>(latency["p99"].number);
+        result.latency_p999_ns = static_cast<uint64_t>(latency["p999"].number);
+        result.latency_max_ns = static_cast<uint64_t>(latency["max"].number);
+        const json_value& cpu = entry["cpu"];
+        result.cpu_user_seconds = cpu["user_seconds"].number;
+        result.cpu_system_seconds = cpu["system_seconds"].number;
+        result.cpu_percent = cpu["percent"].number;
+        results.push_back(result);
+    }
+    return true;
+}
+
+size_t compare_results(const std::vector<bench_result>& baseline,
+                       const std::vector<bench_result>& candidate,
+                       std::ostream& out) {
+    std::map<std::string, std::pair<std::vector<const bench_result*>, std::vector<const bench_result*>>> scenarios;
+    for (const bench_result& result : baseline) {
+        scenarios[scenario_key(result.config)].first.push_back(&result);
+    }
+    for (const bench_result& result : candidate) {
+        scenarios[scenario_key(result.config)].second.push_back(&result);
+    }
+
+    size_t regressions = 0;
+    out << std::fixed << std::setprecision(2);
+    for (const auto& scenario : scenarios) {
+        const auto& base_runs = scenario.second.first;
+        const auto& new_runs = scenario.second.second;
+        out << scenario.first << " (baseline n=" << base_runs.size()
+            << ", candidate n=" << new_runs.size() << ")\n";
+        if (base_runs.empty() || new_runs.empty()) {
+            out << "  not present in both runs, skipped\n";
+            continue;
+        }
+
+        for (const metric& m : compared_metrics) {
+            std::vector<double> base_samples;
+            std::vector<double> new_samples;
+            for (const bench_result* r : base_runs) {
+                base_samples.push_back(m.extract(*r));
+            }
+            for (const bench_result* r : new_runs) {
+                new_samples.push_back(m.extract(*r));
+            }
+            metric_stats a = stats_of(base_samples);
+            metric_stats b = stats_of(new_samples);
+            double delta = b.mean - a.mean;
+            double percent = a.mean != 0.0 ? 100.0 * delta / a.mean : 0.0;
+
+            out << "  " << std::left << std::setw(11) << m.name << std::right
+                << std::setw(16) << a.mean << " -> " << std::setw(16) << b.mean
+                << "  " << std::showpos << std::setw(8) << percent << "%" << std::noshowpos;
+
+            if (a.n < 2 || b.n < 2) {
+                out << "  (need >= 2 repetitions per side for a confidence interval)\n";
+                continue;
+            }
+
+            // Welch's t interval for the difference of means
+            double va = a.variance / static_cast<double>(a.n);
+            double vb = b.variance / static_cast<double>(b.n);
+            double standard_error = std::sqrt(va + vb);
+            double df = (va + vb) * (va + vb);
+            double df_denominator = va * va / static_cast<double>(a.n - 1) + vb * vb / static_cast<double>(b.n - 1);
+            df = df_denominator > 0.0 ? df / df_denominator : static_cast<double>(a.n + b.n - 2);
+            double margin = t_critical_95(df) * standard_error;
+            bool significant = std::fabs(delta) > margin;
+
+            out << "  95% CI [" << std::showpos << delta - margin << ", " << delta + margin << "]" << std::noshowpos;
+            if (significant) {
+                bool improved = m.higher_is_better ? delta > 0.0 : delta < 0.0;
+                out << (improved ? "  improvement" : "  REGRESSION");
+                if (!improved) {
+                    ++regressions;
+                }
+            } else {
+                out << "  no significant change";
+            }
+            out << "\n";
+        }
+    }
+    out << regressions << " significant regression(s)\n";
+    return regressions;
+}
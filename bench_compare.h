@@ -0,0 +1,37 @@
+#ifndef BENCH_COMPARE_H
+#define BENCH_COMPARE_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "bench.h"
+
+/**
+ * @brief Load results previously written by write_json().
+ *
+ * @param path The JSON file to read.
+ * @param results Receives the results in file order.
+ * @param error Receives a description of the problem on failure.
+ * @return true If the file was read and parsed.
+ */
+bool load_results(const std::string& path, std::vector<bench_result>& results, std::string& error);
+
+/**
+ * @brief Compare a candidate run against a stored baseline.
+ *
+ * Results are grouped by scenario (every bench_config field); repeated runs of
+ * the same scenario are the samples. For throughput and the p50/p99/p99.9
+ * latencies, the mean difference and its 95% confidence interval (Welch's t)
+ * are reported. A delta is significant when the interval excludes zero.
+ * Scenarios missing from either side are listed but not compared.
+ *
+ * @param baseline The results of the reference build.
+ * @param candidate The results of the build under test.
+ * @param out Receives the human-readable report.
+ * @return size_t The number of statistically significant regressions.
+ */
+size_t compare_results(const std::vector<bench_result>& baseline,
+                       const std::vector<bench_result>& candidate,
+                       std::ostream& out);
+
+#endif
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "bench_compare.h"
+
+namespace {
+
+bench_result sample_result(double throughput, uint64_t p99_ns) {
+    bench_result r;
+    r.config.variant = queue_variant::safe_queue_lifo;
+    r.config.producers = 2;
+    r.config.consumers = 3;
+    r.config.capacity = 64;
+    r.config.payload_size = 128;
+    r.config.rate = 5000;
+    r.config.duration = std::chrono::milliseconds(250);
+    r.config.pin = true;
+    r.items = 62500;
+    r.seconds = 0.25;
+    r.throughput = throughput;
+    r.latency_p50_ns = 1200;
+    r.latency_p90_ns = 2400;
+    r.latency_p99_ns = p99_ns;
+    r.latency_p999_ns = 96000;
+    r.latency_max_ns = 150000;
+    r.cpu_user_seconds = 0.125;
+    r.cpu_system_seconds = 0.0625;
+    r.cpu_percent = 75;
+    return r;
+}
+
+std::vector<bench_result> runs(const std::vector<double>& throughputs, uint64_t p99_ns) {
+    std::vector<bench_result> results;
+    for (double t : throughputs) {
+        results.push_back(sample_result(t, p99_ns));
+    }
+    return results;
+}
+
+/// Write @p text to a temporary file and load it
+bool load_text(const std::string& text, std::vector<bench_result>& results, std::string& error) {
+    const std::string path = ::testing::TempDir() + "bench_compare_input.json";
+    {
+        std::ofstream file(path);
+        file << text;
+    }
+    const bool loaded = load_results(path, results, error);
+    std::remove(path.c_str());
+    return loaded;
+}
+
+} // namespace
+
+TEST(BenchCompareTest, WriteJsonRoundTrips) {
+    std::vector<bench_result> written = {sample_result(250000, 48000), sample_result(125000, 24000)};
+    written[1].config.variant = queue_variant::thread_safe_queue;
+    written[1].config.pin = false;
+    std::ostringstream json;
+    write_json(json, written);
+
+    std::vector<bench_result> loaded;
+    std::string error;
+    ASSERT_TRUE(load_text(json.str(), loaded, error)) << error;
+    ASSERT_EQ(loaded.size(), written.size());
+    for (size_t i = 0; i < written.size(); ++i) {
+        const bench_result& a = written[i];
+        const bench_result& b = loaded[i];
+        EXPECT_EQ(b.config.variant, a.config.variant);
+        EXPECT_EQ(b.config.producers, a.config.producers);
+        EXPECT_EQ(b.config.consumers, a.config.consumers);
+        EXPECT_EQ(b.config.capacity, a.config.capacity);
+        EXPECT_EQ(b.config.payload_size, a.config.payload_size);
+        EXPECT_EQ(b.config.rate, a.config.rate);
+        EXPECT_EQ(b.config.duration, a.config.duration);
+        EXPECT_EQ(b.config.pin, a.config.pin);
+        EXPECT_EQ(b.items, a.items);
+        EXPECT_EQ(b.seconds, a.seconds);
+        EXPECT_EQ(b.throughput, a.throughput);
+        EXPECT_EQ(b.latency_p50_ns, a.latency_p50_ns);
+        EXPECT_EQ(b.latency_p90_ns, a.latency_p90_ns);
+        EXPECT_EQ(b.latency_p99_ns, a.latency_p99_ns);
+        EXPECT_EQ(b.latency_p999_ns, a.latency_p999_ns);
+        EXPECT_EQ(b.latency_max_ns, a.latency_max_ns);
+        EXPECT_EQ(b.cpu_user_seconds, a.cpu_user_seconds);
+        EXPECT_EQ(b.cpu_system_seconds, a.cpu_system_seconds);
+        EXPECT_EQ(b.cpu_percent, a.cpu_percent);
+    }
+}
+
+TEST(BenchCompareTest, RejectsMalformedInput) {
+    std::vector<bench_result> loaded;
+    std::string error;
+    EXPECT_FALSE(load_text("[{\"queue\": \"safe_queue\"", loaded, error));
+    EXPECT_NE(error.find("malformed JSON"), std::string::npos);
+    EXPECT_FALSE(load_text("[] trailing", loaded, error));
+    EXPECT_FALSE(load_text("{\"queue\": \"safe_queue\"}", loaded, error));
+    EXPECT_NE(error.find("expected an array"), std::string::npos);
+    EXPECT_FALSE(load_text("[{\"queue\": \"no_such_queue\"}]", loaded, error));
+    EXPECT_NE(error.find("no_such_queue"), std::string::npos);
+    EXPECT_FALSE(load_results(::testing::TempDir() + "missing_results.json", loaded, error));
+    EXPECT_NE(error.find("cannot open"), std::string::npos);
+    EXPECT_TRUE(loaded.empty());
+}
+
+TEST(BenchCompareTest, FlagsSignificantThroughputRegression) {
+    std::ostringstream report;
+    const size_t regressions = compare_results(runs({100000, 101000, 99000, 100500}, 48000),
+                                               runs({90000, 91000, 89500, 90500}, 48000), report);
+    EXPECT_EQ(regressions, 1u);
+    EXPECT_NE(report.str().find("REGRESSION"), std::string::npos);
+}
+
+TEST(BenchCompareTest, FlagsSignificantLatencyRegression) {
+    std::ostringstream report;
+    std::vector<bench_result> candidate = runs({100000, 101000, 99000, 100500}, 48000);
+    const uint64_t p99[] = {60000, 61000, 59000, 60500};
+    for (size_t i = 0; i < candidate.size(); ++i) {
+        candidate[i].latency_p99_ns = p99[i];
+    }
+    std::vector<bench_result> baseline = runs({100000, 101000, 99000, 100500}, 48000);
+    const uint64_t base_p99[] = {48000, 48500, 47500, 48200};
+    for (size_t i = 0; i < baseline.size(); ++i) {
+        baseline[i].latency_p99_ns = base_p99[i];
+    }
+    EXPECT_EQ(compare_results(baseline, candidate, report), 1u);
+}
+
+TEST(BenchCompareTest, NoisyOrImprovedRunsAreNotRegressions) {
+    std::ostringstream noisy;
+    EXPECT_EQ(compare_results(runs({100000, 110000, 90000, 105000}, 48000),
+                              runs({98000, 108000, 92000, 101000}, 48000), noisy), 0u);
+    EXPECT_NE(noisy.str().find("no significant change"), std::string::npos);
+
+    std::ostringstream improved;
+    EXPECT_EQ(compare_results(runs({100000, 101000, 99000, 100500}, 48000),
+                              runs({120000, 121000, 119000, 120500}, 48000), improved), 0u);
+    EXPECT_NE(improved.str().find("improvement"), std::string::npos);
+}
+
+TEST(BenchCompareTest, SkipsUnmatchedAndSingleRunScenarios) {
+    std::vector<bench_result> other = runs({50000, 50000}, 48000);
+    for (bench_result& r : other) {
+        r.config.producers = 8;
+    }
+    std::ostringstream report;
+    EXPECT_EQ(compare_results(runs({100000}, 48000), runs({50000}, 48000), report), 0u);
+    EXPECT_NE(report.str().find("need >= 2 repetitions"), std::string::npos);
+    EXPECT_EQ(compare_results(runs({100000, 100000}, 48000), other, report), 0u);
+    EXPECT_NE(report.str().find("not present in both runs"), std::string::npos);
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "bench.h"
+
+TEST(LatencyHistogramTest, EmptyHistogramReportsZero) {
+    latency_histogram histogram;
+    EXPECT_EQ(histogram.count(), 0u);
+    EXPECT_EQ(histogram.percentile(0.5), 0u);
+    EXPECT_EQ(histogram.max(), 0u);
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+    latency_histogram histogram;
+    for (uint64_t ns = 0; ns < 16; ++ns) {
+        histogram.record(ns);
+    }
+    EXPECT_EQ(histogram.count(), 16u);
+    EXPECT_EQ(histogram.percentile(0.0), 0u);
+    EXPECT_EQ(histogram.percentile(0.5), 7u);
+    EXPECT_EQ(histogram.percentile(1.0), 15u);
+    EXPECT_EQ(histogram.max(), 15u);
+}
+
+TEST(LatencyHistogramTest, PercentilesStayWithinBucketResolution) {
+    for (uint64_t ns : {17ull, 100ull, 1000ull, 123456ull, 987654321ull}) {
+        latency_histogram histogram;
+        histogram.record(ns);
+        histogram.record(ns * 4);
+        const uint64_t p50 = histogram.percentile(0.5);
+        EXPECT_GE(p50, ns);
+        EXPECT_LE(p50, ns + ns / 16);
+        EXPECT_EQ(histogram.percentile(1.0), ns * 4);
+    }
+}
+
+TEST(LatencyHistogramTest, TailPercentilesOfKnownDistribution) {
+    latency_histogram fast;
+    latency_histogram slow;
+    for (int i = 0; i < 990; ++i) {
+        fast.record(1000);
+    }
+    for (int i = 0; i < 10; ++i) {
+        slow.record(1000000);
+    }
+    fast.merge(slow);
+    EXPECT_EQ(fast.count(), 1000u);
+    EXPECT_EQ(fast.max(), 1000000u);
+    EXPECT_GE(fast.percentile(0.50), 1000u);
+    EXPECT_LE(fast.percentile(0.50), 1000u + 1000u / 16);
+    EXPECT_LE(fast.percentile(0.99), 1000u + 1000u / 16);
+    EXPECT_EQ(fast.percentile(0.999), 1000000u);
+}
+
+TEST(PerfCountersTest, UnavailableCountersAreReportedAsMissing) {
+    perf_counters::sample before;
+    perf_counters::sample after;
+    before.available[perf_counters::cycles] = true;
+    after.available[perf_counters::cycles] = true;
+    before.values[perf_counters::cycles] = 1000;
+    after.values[perf_counters::cycles] = 5000;
+    after.available[perf_counters::context_switches] = true;  // unreadable at the start
+    after.values[perf_counters::context_switches] = 7;
+
+    bench_result result;
+    result.items = 2000;
+    result.counters = after - before;
+    double value = 0.0;
+    ASSERT_TRUE(counter_per_million(result, perf_counters::cycles, value));
+    EXPECT_DOUBLE_EQ(value, 2e6);
+    EXPECT_FALSE(counter_per_million(result, perf_counters::context_switches, value));
+    EXPECT_FALSE(counter_per_million(result, perf_counters::instructions, value));
+    EXPECT_EQ(result.counters.values[perf_counters::context_switches], 0u);
+
+    std::ostringstream json;
+    write_json(json, {result});
+    EXPECT_NE(json.str().find("\"cycles\": 2e+06"), std::string::npos);
+    EXPECT_NE(json.str().find("\"instructions\": null"), std::string::npos);
+
+    result.items = 0;
+    EXPECT_FALSE(counter_per_million(result, perf_counters::cycles, value));
+}
+
+TEST(PerfCountersTest, ReadingWorksWithoutPerfSupport) {
+    // Containers often refuse perf_event_open; the counters must degrade, not fail
+    perf_counters counters;
+    counters.start();
+    const perf_counters::sample first = counters.read();
+    counters.stop();
+    const perf_counters::sample second = counters.read();
+    for (size_t i = 0; i < perf_counters::counter_count; ++i) {
+        if (!counters.any_available()) {
+            EXPECT_FALSE(first.available[i]);
+        }
+        if (first.available[i] && second.available[i]) {
+            EXPECT_GE(second.values[i], first.values[i]);
+        }
+    }
+}
+
+TEST(SweepThreadCountsTest, PowersOfTwoCappedAtMaximum) {
+    EXPECT_EQ(sweep_thread_counts(0), (std::vector<size_t>{1}));
+    EXPECT_EQ(sweep_thread_counts(1), (std::vector<size_t>{1}));
+    EXPECT_EQ(sweep_thread_counts(2), (std::vector<size_t>{1, 2}));
+    EXPECT_EQ(sweep_thread_counts(6), (std::vector<size_t>{1, 2, 4, 6}));
+    EXPECT_EQ(sweep_thread_counts(8), (std::vector<size_t>{1, 2, 4, 8}));
+    EXPECT_EQ(sweep_thread_counts(9), (std::vector<size_t>{1, 2, 4, 8, 9}));
+}
@@ -0,0 +1,268 @@
+#ifndef BYTE_QUEUE_H
+#define BYTE_QUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include "enqueue.h"
+#include "memory_budget.h"
+#include "queue_clock.h"
+#include "queue_counters.h"
+#include "queue_wait.h"
+
+/**
+ * @brief A thread-safe FIFO queue bounded by the total weight of its items.
+ *
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Weigher Callable size_t(const T&) returning the cost of an item,
+ *         typically its size in bytes.
+ * @tparam Clock Clock policy used by the timed operations (see queue_clock.h).
+ *
+ * Where safe_queue bounds the number of items, byte_queue bounds the sum of
+ * their weights, so a few large items and many small ones use the same memory
+ * envelope. Each item is weighed once, on push. Producers block (push,
+ * try_push) or are rejected (offer) while the item does not fit in the
+ * remaining budget. An item heavier than the whole budget is admitted only
+ * into an empty queue, so it cannot wait forever.
+ *
+ * Items are taken by value and moved in and out, so large payloads are never
+ * copied by the queue. The current byte total is readable lock-free through
+ * bytes() and counters().
+ *
+ * A queue constructed with a memory_budget::account additionally draws the
+ * weight of every queued item from that shared budget, so many queues can be
+ * sized for their bursts while their sum stays bounded. Producers wait for the
+ * shared budget before taking the queue lock, so consumers are never blocked
+ * by it.
+ */
+template <typename T, typename Weigher = std::function<size_t(const T&)>, typename Clock = steady_clock_policy>
+class byte_queue {
+public:
+    /**
+     * @brief Construct a queue holding at most @p byte_budget weight units.
+     *
+     * @param byte_budget The maximum total weight of the queued items.
+     * @param weigher Computes the weight of an item.
+     */
+    byte_queue(size_t byte_budget, Weigher weigher = Weigher())
+        : budget(byte_budget), weigh(std::move(weigher)) {
+        counters_data.byte_budget.store(budget, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Construct a queue that also draws item weights from a shared budget.
+     *
+     * @param byte_budget The maximum total weight of the queued items.
+     * @param weigher Computes the weight of an item.
+     * @param shared The account to charge; must outlive the queue.
+     */
+    byte_queue(size_t byte_budget, Weigher weigher, memory_budget::account& shared)
+        : byte_queue(byte_budget, std::move(weigher)) {
+        account = &shared;
+    }
+
+    /**
+     * @brief Destroy the queue, returning the weight of remaining items to the shared budget.
+     */
+    ~byte_queue() {
+        if (account != nullptr) {
+            account->release(used);
+        }
+    }
+
+    byte_queue(const byte_queue&) = delete;
+    byte_queue& operator=(const byte_queue&) = delete;
+
+    /**
+     * @brief Push an item, blocking until it fits or the queue is closed.
+     *
+     * @return queue_status::ok If the item was pushed.
+     * @return queue_status::timeout If the item can never fit in the shared budget.
+     * @return queue_status::closed If the queue is closed.
+     */
+    queue_status push(T item) {
+        const size_t weight = weigh(item);
+        if (account != nullptr && !account->acquire(weight)) {
+            return queue_status::timeout;
+        }
+        std::unique_lock<std::mutex> lock(mutex_sync);
+        counted_wait(has_room, lock, [this, weight]() { return closed_flag || fits(weight); },
+                     counters_data, wait_side::producer);
+        if (closed_flag) {
+            refund(weight);
+            return queue_status::closed;
+        }
+        enqueue_locked(std::move(item), weight);
+        return queue_status::ok;
+    }
+
+    /**
+     * @brief Push an item, waiting at most @p timeout for it to fit.
+     *
+     * @return queue_status::ok, queue_status::timeout or queue_status::closed.
+     */
+    queue_status try_push(T item, const std::chrono::milliseconds& timeout) {
+        const size_t weight = weigh(item);
+        // One deadline covers both waits, so time spent on the shared budget
+        // counts against the same timeout as the wait for room in the queue
+        const typename Clock::time_point deadline = Clock::now() + timeout;
+        if (account != nullptr && !account->acquire_for(weight, timeout)) {
+            bump_counter(counters_data.timeouts);
+            return queue_status::timeout;
+        }
+        std::unique_lock<std::mutex> lock(mutex_sync);
+        if (!counted_wait_until<Clock>(has_room, lock, [this, weight]() { return closed_flag || fits(weight); },
+                                       deadline, counters_data, wait_side::producer)) {
+            refund(weight);
+            return queue_status::timeout;
+        }
+        if (closed_flag) {
+            refund(weight);
+            return queue_status::closed;
+        }
+        enqueue_locked(std::move(item), weight);
+        return queue_status::ok;
+    }
+
+    /**
+     * @brief Push an item only if it fits right now.
+     *
+     * @return queue_status::ok If the item was pushed.
+     * @return queue_status::timeout If the budget is exhausted (the item is rejected).
+     * @return queue_status::closed If the queue is closed.
+     */
+    queue_status offer(T item) {
+        const size_t weight = weigh(item);
+        std::lock_guard<std::mutex> lock(mutex_sync);
+        if (closed_flag) {
+            return queue_status::closed;
+        }
+        if (!fits(weight) || (account != nullptr && !account->try_acquire(weight))) {
+            return queue_status::timeout;
+        }
+        enqueue_locked(std::move(item), weight);
+        return queue_status::ok;
+    }
+
+    /**
+     * @brief Pop an item, blocking until one is available or the queue is closed and empty.
+     *
+     * @return queue_status::ok If an item was moved into @p item.
+     * @return queue_status::closed If the queue is closed and has been drained.
+     */
+    queue_status pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_sync);
+        counted_wait(has_items, lock, [this]() { return closed_flag || !items.empty(); },
+                     counters_data, wait_side::consumer);
+        if (items.empty()) {
+            return queue_status::closed;
+        }
+        item = dequeue_locked();
+        return queue_status::ok;
+    }
+
+    /**
+     * @brief Pop an item, waiting at most @p timeout for one.
+     *
+     * @return queue_status::ok, queue_status::timeout or queue_status::closed.
+     */
+    queue_status try_pop(T& item, const std::chrono::milliseconds& timeout) {
+        std::unique_lock<std::mutex> lock(mutex_sync);
+        const typename Clock::time_point deadline = Clock::now() + timeout;
+        if (!counted_wait_until<Clock>(has_items, lock, [this]() { return closed_flag || !items.empty(); },
+                                       deadline, counters_data, wait_side::consumer)) {
+            return queue_status::timeout;
+        }
+        if (items.empty()) {
+            return queue_status::closed;
+        }
+        item = dequeue_locked();
+        return queue_status::ok;
+    }
+
+    /**
+     * @brief Close the queue; see safe_queue::close().
+     */
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_sync);
+        closed_flag = true;
+        has_room.notify_all();
+        has_items.notify_all();
+    }
+
+    /**
+     * @brief Get the number of queued items.
+     */
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_sync);
+        return items.size();
+    }
+
+    /**
+     * @brief Get the total weight of the queued items, without locking.
+     */
+    size_t bytes() const { return counters_data.bytes.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the weight budget.
+     */
+    size_t byte_budget() const { return budget; }
+
+    /**
+     * @brief Get the activity counters of the queue; see safe_queue::counters().
+     */
+    const queue_counters& counters() const { return counters_data; }
+
+private:
+    bool fits(size_t weight) const {
+        return items.empty() || (used <= budget && weight <= budget - used);
+    }
+
+    void enqueue_locked(T&& item, size_t weight) {
+        items.emplace_back(std::move(item), weight);
+        used += weight;
+        bump_counter(counters_data.pushes);
+        counters_data.depth.store(items.size(), std::memory_order_relaxed);
+        counters_data.bytes.store(used, std::memory_order_relaxed);
+        has_items.notify_one();
+    }
+
+    T dequeue_locked() {
+        T item = std::move(items.front().first);
+        used -= items.front().second;
+        refund(items.front().second);
+        items.pop_front();
+        bump_counter(counters_data.pops);
+        counters_data.depth.store(items.size(), std::memory_order_relaxed);
+        counters_data.bytes.store(used, std::memory_order_relaxed);
+        // One pop can free room for several small items.
+        if (counters_data.waiting_producers.load(std::memory_order_relaxed) > 0) {
+            has_room.notify_all();
+        }
+        return item;
+    }
+
+    /// Return @p weight to the shared budget, if any
+    void refund(size_t weight) {
+        if (account != nullptr) {
+            account->release(weight);
+        }
+    }
+
+    const size_t budget;                        ///< Maximum total weight
+    Weigher weigh;                              ///< Computes item weights
+    std::deque<std::pair<T, size_t>> items;     ///< Items with their weight at push time
+    size_t used = 0;                            ///< Total weight of items
+    bool closed_flag = false;                   ///< Set once by close()
+    mutable std::mutex mutex_sync;              ///< Guards items, used and closed_flag
+    std::condition_variable has_room;           ///< Signalled when weight is released
+    std::condition_variable has_items;          ///< Signalled when an item is pushed
+    queue_counters counters_data;               ///< Lock-free activity counters
+    memory_budget::account* account = nullptr;  ///< Shared budget charged for queued items, if any
+};
+
+#endif
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "byte_queue.h"
+
+namespace {
+
+size_t string_bytes(const std::string& s) {
+    return s.size();
+}
+
+} // namespace
+
+TEST(ByteQueueTest, BoundsTotalWeight) {
+    byte_queue<std::string> q(10, string_bytes);
+    EXPECT_EQ(q.offer(std::string(4, 'a')), queue_status::ok);
+    EXPECT_EQ(q.offer(std::string(6, 'b')), queue_status::ok);
+    EXPECT_EQ(q.bytes(), 10u);
+    EXPECT_EQ(q.offer("c"), queue_status::timeout);
+    EXPECT_EQ(q.try_push("c", std::chrono::milliseconds(10)), queue_status::timeout);
+    EXPECT_EQ(q.counters().timeouts.load(), 1u);
+
+    std::string item;
+    EXPECT_EQ(q.pop(item), queue_status::ok);
+    EXPECT_EQ(item, "aaaa");
+    EXPECT_EQ(q.bytes(), 6u);
+    EXPECT_EQ(q.offer("cccc"), queue_status::ok);
+    EXPECT_EQ(q.size(), 2u);
+    EXPECT_EQ(q.counters().byte_budget.load(), 10u);
+}
+
+TEST(ByteQueueTest, OversizedItemOnlyEntersEmptyQueue) {
+    byte_queue<std::string> q(10, string_bytes);
+    EXPECT_EQ(q.offer("x"), queue_status::ok);
+    EXPECT_EQ(q.offer(std::string(20, 'y')), queue_status::timeout);
+
+    std::string item;
+    EXPECT_EQ(q.pop(item), queue_status::ok);
+    EXPECT_EQ(q.offer(std::string(20, 'y')), queue_status::ok);
+    EXPECT_EQ(q.bytes(), 20u);
+    EXPECT_EQ(q.offer("z"), queue_status::timeout);
+}
+
+TEST(ByteQueueTest, PopReleasesBlockedProducers) {
+    byte_queue<std::string> q(8, string_bytes);
+    ASSERT_EQ(q.push(std::string(8, 'a')), queue_status::ok);
+
+    std::thread producer([&q] {
+        EXPECT_EQ(q.push("bbbb"), queue_status::ok);
+        EXPECT_EQ(q.push("cccc"), queue_status::ok);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(q.counters().waiting_producers.load(), 1u);
+
+    std::string item;
+    EXPECT_EQ(q.pop(item), queue_status::ok);
+    producer.join();
+    EXPECT_EQ(q.bytes(), 8u);
+    EXPECT_EQ(q.pop(item), queue_status::ok);
+    EXPECT_EQ(item, "bbbb");
+}
+
+TEST(ByteQueueTest, CloseDrainsThenReportsClosed) {
+    byte_queue<std::string> q(8, string_bytes);
+    q.push("a");
+    q.close();
+    EXPECT_EQ(q.push("b"), queue_status::closed);
+    std::string item;
+    EXPECT_EQ(q.try_pop(item, std::chrono::milliseconds(10)), queue_status::ok);
+    EXPECT_EQ(q.pop(item), queue_status::closed);
+}
+
+TEST(ByteQueueTest, SharedBudgetWaitUsesTheQueueClock) {
+    virtual_clock::reset();
+    memory_budget budget(8);
+    memory_budget::account mine(budget, 0);
+    memory_budget::account other(budget, 0);
+    byte_queue<std::string, size_t (*)(const std::string&), virtual_clock> q(4, string_bytes, mine);
+    ASSERT_EQ(q.offer("aaaa"), queue_status::ok);
+    ASSERT_TRUE(other.acquire(4));
+
+    // The shared budget frees up in real time; the queue then stays full
+    // and the rest of the wait must run to the full virtual timeout
+    std::thread releaser([&other]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        other.release(4);
+    });
+    EXPECT_EQ(q.try_push("bbbb", std::chrono::milliseconds(50)), queue_status::timeout);
+    releaser.join();
+    EXPECT_EQ(virtual_clock::now().time_since_epoch(), std::chrono::milliseconds(50));
+    EXPECT_EQ(mine.used(), 4u);
+    virtual_clock::reset();
+}
@@ -0,0 +1,196 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include "enqueue.h"
+
+/**
+ * @brief Queue shared by the sender and receiver handles of one channel.
+ *
+ * @tparam T The type of elements sent through the channel.
+ * @tparam Clock Clock policy of the underlying safe_queue.
+ */
+template <typename T, typename Clock = steady_clock_policy>
+struct channel_state {
+    explicit channel_state(size_t capacity) : queue(capacity) {}
+
+    safe_queue<T, Clock> queue;         ///< The items in flight
+    std::atomic<size_t> senders{1};     ///< Live sender handles
+    std::atomic<size_t> receivers{1};   ///< Live receiver handles
+};
+
+/**
+ * @brief Producer handle of a channel.
+ *
+ * Copies share the channel and count as separate senders. When the last
+ * sender is destroyed (or reset), the queue is closed: receivers drain the
+ * remaining items and then get queue_status::closed, so no sentinel item or
+ * polling timeout is needed to detect the end of the stream.
+ *
+ * @tparam T The type of elements sent through the channel.
+ * @tparam Clock Clock policy of the underlying safe_queue.
+ */
+template <typename T, typename Clock = steady_clock_policy>
+class sender {
+public:
+    sender() = default;
+
+    /// Adopt the initial sender count of @p state; use make_channel() instead.
+    explicit sender(std::shared_ptr<channel_state<T, Clock>> state) : state(std::move(state)) {}
+
+    sender(const sender& other) : state(other.state) {
+        if (state) {
+            state->senders.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    sender(sender&& other) noexcept = default;
+
+    sender& operator=(sender other) noexcept {
+        std::swap(state, other.state);
+        return *this;
+    }
+
+    ~sender() { reset(); }
+
+    /**
+     * @brief Release this handle; closes the channel if it was the last sender.
+     */
+    void reset() {
+        if (state && state->senders.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            state->queue.close();
+        }
+        state.reset();
+    }
+
+    /**
+     * @brief Send an item, blocking while the channel is full.
+     *
+     * @return queue_status::ok If the item was queued.
+     * @return queue_status::closed If every receiver is gone (or the handle is empty).
+     */
+    queue_status send(const T& item) {
+        return state ? state->queue.wait_push(item) : queue_status::closed;
+    }
+
+    /**
+     * @brief Send an item, waiting at most @p timeout for space.
+     *
+     * @return queue_status::ok, queue_status::timeout or queue_status::closed.
+     */
+    queue_status try_send(const T& item, const std::chrono::milliseconds& timeout) {
+        return state ? state->queue.try_push(item, timeout) : queue_status::closed;
+    }
+
+    /**
+     * @brief Check if the receiving side is gone, so sends would fail.
+     */
+    bool closed() const { return !state || state->queue.closed(); }
+
+    /**
+     * @brief Check if this handle refers to a channel.
+     */
+    explicit operator bool() const { return static_cast<bool>(state); }
+
+private:
+    std::shared_ptr<channel_state<T, Clock>> state;
+};
+
+/**
+ * @brief Consumer handle of a channel.
+ *
+ * Copies share the channel and count as separate receivers. When the last
+ * receiver is destroyed (or reset), the queue is closed, so blocked and
+ * future sends fail fast with queue_status::closed instead of filling a queue
+ * nobody reads.
+ *
+ * @tparam T The type of elements sent through the channel.
+ * @tparam Clock Clock policy of the underlying safe_queue.
+ */
+template <typename T, typename Clock = steady_clock_policy>
+class receiver {
+public:
+    receiver() = default;
+
+    /// Adopt the initial receiver count of @p state; use make_channel() instead.
+    explicit receiver(std::shared_ptr<channel_state<T, Clock>> state) : state(std::move(state)) {}
+
+    receiver(const receiver& other) : state(other.state) {
+        if (state) {
+            state->receivers.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    receiver(receiver&& other) noexcept = default;
+
+    receiver& operator=(receiver other) noexcept {
+        std::swap(state, other.state);
+        return *this;
+    }
+
+    ~receiver() { reset(); }
+
+    /**
+     * @brief Release this handle; closes the channel if it was the last receiver.
+     */
+    void reset() {
+        if (state && state->receivers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            state->queue.close();
+        }
+        state.reset();
+    }
+
+    /**
+     * @brief Receive an item, blocking while the channel is empty.
+     *
+     * @return queue_status::ok If an item was stored in @p item.
+     * @return queue_status::closed If every sender is gone and the channel is drained.
+     */
+    queue_status receive(T& item) {
+        return state ? state->queue.wait_pop(item) : queue_status::closed;
+    }
+
+    /**
+     * @brief Receive an item, waiting at most @p timeout for one.
+     *
+     * @return queue_status::ok, queue_status::timeout or queue_status::closed.
+     */
+    queue_status try_receive(T& item, const std::chrono::milliseconds& timeout) {
+        return state ? state->queue.try_pop(item, timeout) : queue_status::closed;
+    }
+
+    /**
+     * @brief Check if this handle refers to a channel.
+     */
+    explicit operator bool() const { return static_cast<bool>(state); }
+
+    /**
+     * @brief Get the activity counters of the underlying queue, e.g. for queue_registry.
+     *
+     * An empty handle reports a shared set of counters that stay at zero.
+     */
+    const queue_counters& counters() const {
+        static const queue_counters none;
+        return state ? state->queue.counters() : none;
+    }
+
+private:
+    std::shared_ptr<channel_state<T, Clock>> state;
+};
+
+/**
+ * @brief Create a channel with one sender and one receiver handle.
+ *
+ * @param capacity The maximum number of items in flight.
+ */
+template <typename T, typename Clock = steady_clock_policy>
+std::pair<sender<T, Clock>, receiver<T, Clock>> make_channel(size_t capacity) {
+    auto state = std::make_shared<channel_state<T, Clock>>(capacity);
+    return {sender<T, Clock>(state), receiver<T, Clock>(state)};
+}
+
+#endif
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "channel.h"
+
+TEST(ChannelTest, LastSenderClosesAfterDrain) {
+    auto channel = make_channel<int>(4);
+    receiver<int> rx = std::move(channel.second);
+    {
+        sender<int> tx = std::move(channel.first);
+        sender<int> copy = tx;
+        EXPECT_EQ(tx.send(1), queue_status::ok);
+        EXPECT_EQ(copy.send(2), queue_status::ok);
+        tx.reset();
+        EXPECT_EQ(copy.send(3), queue_status::ok);  // one sender is still alive
+    }
+    int value = 0;
+    for (int expected = 1; expected <= 3; ++expected) {
+        ASSERT_EQ(rx.receive(value), queue_status::ok);
+        EXPECT_EQ(value, expected);
+    }
+    EXPECT_EQ(rx.receive(value), queue_status::closed);
+    EXPECT_EQ(rx.try_receive(value, std::chrono::milliseconds(10)), queue_status::closed);
+}
+
+TEST(ChannelTest, DroppingReceiversFailsSends) {
+    auto channel = make_channel<int>(1);
+    sender<int> tx = std::move(channel.first);
+    EXPECT_EQ(tx.send(1), queue_status::ok);
+    EXPECT_FALSE(tx.closed());
+
+    // A sender blocked on the full channel is woken when the receiver goes.
+    std::thread blocked([&tx] { EXPECT_EQ(tx.send(2), queue_status::closed); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    channel.second.reset();
+    blocked.join();
+
+    EXPECT_TRUE(tx.closed());
+    EXPECT_EQ(tx.send(3), queue_status::closed);
+    EXPECT_EQ(tx.try_send(3, std::chrono::milliseconds(10)), queue_status::closed);
+}
+
+TEST(ChannelTest, ReceiversStopWhenAllProducersFinish) {
+    const int producers = 4;
+    const int items_per_producer = 1000;
+    auto channel = make_channel<int>(16);
+    std::vector<std::thread> threads;
+    std::atomic<long> sum(0);
+    std::atomic<int> received(0);
+
+    for (int c = 0; c < 2; ++c) {
+        threads.emplace_back([rx = channel.second, &sum, &received]() mutable {
+            int value;
+            while (rx.receive(value) == queue_status::ok) {
+                sum += value;
+                ++received;
+            }
+        });
+    }
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([tx = channel.first]() mutable {
+            for (int i = 1; i <= items_per_producer; ++i) {
+                ASSERT_EQ(tx.send(i), queue_status::ok);
+            }
+        });
+    }
+    channel.first.reset();
+    channel.second.reset();
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(received, producers * items_per_producer);
+    EXPECT_EQ(sum, static_cast<long>(producers) * items_per_producer * (items_per_producer + 1) / 2);
+}
+
+TEST(ChannelTest, EmptyReceiverReportsZeroCounters) {
+    receiver<int> rx;
+    EXPECT_EQ(rx.counters().pushes.load(), 0u);
+    auto channel = make_channel<int>(2);
+    channel.first.send(1);
+    receiver<int> moved = std::move(channel.second);
+    EXPECT_EQ(channel.second.counters().depth.load(), 0u);
+    EXPECT_EQ(moved.counters().depth.load(), 1u);
+}
@@ -0,0 +1,268 @@
+#ifndef COMPACT_QUEUE_H
+#define COMPACT_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include "enqueue.h"
+#include "parking_lot.h"
+
+/**
+ * @brief A bounded thread-safe FIFO queue with a few words of sync state.
+ *
+ * @tparam T The type of elements stored in the queue.
+ *
+ * safe_queue embeds a mutex and two condition variables, well over a hundred
+ * bytes per queue. compact_queue keeps all of its synchronization in one
+ * 32-bit atomic word: a lock bit, "threads parked" bits for the lock, the
+ * producers and the consumers, and the closed flag. Threads that must block
+ * park in the process-wide parking_lot, keyed by addresses inside the state
+ * word, so a queue is a buffer pointer, three 32-bit indices and the state
+ * word, whatever the number of waiters.
+ *
+ * The lock is held only for the ring update and spins briefly before
+ * parking. Operations mirror the closable API of safe_queue; timeouts always
+ * use std::chrono::steady_clock. There are no activity counters, as they
+ * would be larger than the queue itself.
+ */
+template <typename T>
+class compact_queue {
+public:
+    /**
+     * @brief Construct a queue of at most @p max_capacity items (below 2^32).
+     */
+    explicit compact_queue(uint32_t max_capacity) : slots(new T[max_capacity]), capacity(max_capacity) {}
+
+    ~compact_queue() { delete[] slots; }
+
+    compact_queue(const compact_queue&) = delete;
+    compact_queue& operator=(const compact_queue&) = delete;
+
+    /**
+     * @brief Push an item, blocking while the queue is full.
+     *
+     * @return queue_status::ok or queue_status::closed.
+     */
+    queue_status push(T item) {
+        return push_until(std::move(item), nullptr);
+    }
+
+    /**
+     * @brief Push an item, waiting at most @p timeout for room.
+     *
+     * @return queue_status::ok, queue_status::timeout or queue_status::closed.
+     */
+    queue_status try_push(T item, const std::chrono::milliseconds& timeout) {
+        const parking_lot::clock::time_point deadline = parking_lot::clock::now() + timeout;
+        return push_until(std::move(item), &deadline);
+    }
+
+    /**
+     * @brief Pop an item, blocking until one is available or the queue is closed and drained.
+     *
+     * @return queue_status::ok or queue_status::closed.
+     */
+    queue_status pop(T& item) {
+        return pop_until(item, nullptr);
+    }
+
+    /**
+     * @brief Pop an item, waiting at most @p timeout for one.
+     *
+     * @return queue_status::ok, queue_status::timeout or queue_status::closed.
+     */
+    queue_status try_pop(T& item, const std::chrono::milliseconds& timeout) {
+        const parking_lot::clock::time_point deadline = parking_lot::clock::now() + timeout;
+        return pop_until(item, &deadline);
+    }
+
+    /**
+     * @brief Close the queue; see safe_queue::close().
+     */
+    void close() {
+        {
+            ring_guard guard(*this);
+            state.fetch_or(closed_bit, std::memory_order_relaxed);
+        }
+        parking_lot::unpark_all(producer_key());
+        parking_lot::unpark_all(consumer_key());
+    }
+
+    /**
+     * @brief Check if the queue has been closed.
+     */
+    bool closed() const { return (state.load(std::memory_order_acquire) & closed_bit) != 0; }
+
+    /**
+     * @brief Get the number of queued items.
+     */
+    size_t size() {
+        ring_guard guard(*this);
+        return count;
+    }
+
+private:
+    static constexpr uint32_t locked_bit = 1;               ///< The ring is owned by a thread
+    static constexpr uint32_t lock_parked_bit = 2;          ///< Threads are parked waiting for the lock
+    static constexpr uint32_t producers_parked_bit = 4;     ///< Producers are parked on a full queue
+    static constexpr uint32_t consumers_parked_bit = 8;     ///< Consumers are parked on an empty queue
+    static constexpr uint32_t closed_bit = 16;              ///< close() was called
+    static constexpr int spin_limit = 40;                   ///< Lock attempts before parking
+
+    // Parking keys: distinct addresses inside the state word.
+    const void* lock_key() const { return &state; }
+    const void* producer_key() const { return reinterpret_cast<const char*>(&state) + 1; }
+    const void* consumer_key() const { return reinterpret_cast<const char*>(&state) + 2; }
+
+    void lock() {
+        uint32_t s = state.load(std::memory_order_relaxed);
+        if ((s & locked_bit) == 0 &&
+            state.compare_exchange_weak(s, s | locked_bit, std::memory_order_acquire, std::memory_order_relaxed)) {
+            return;
+        }
+        lock_slow();
+    }
+
+    void lock_slow() {
+        int spins = 0;
+        for (;;) {
+            uint32_t s = state.load(std::memory_order_relaxed);
+            if ((s & locked_bit) == 0) {
+                if (state.compare_exchange_weak(s, s | locked_bit, std::memory_order_acquire,
+                                                std::memory_order_relaxed)) {
+                    return;
+                }
+                continue;
+            }
+            if (spins < spin_limit && (s & lock_parked_bit) == 0) {
+                ++spins;
+                std::this_thread::yield();
+                continue;
+            }
+            if ((s & lock_parked_bit) == 0 &&
+                !state.compare_exchange_weak(s, s | lock_parked_bit, std::memory_order_relaxed)) {
+                continue;
+            }
+            parking_lot::park(lock_key(), [this]() {
+                const uint32_t now = state.load(std::memory_order_relaxed);
+                return (now & (locked_bit | lock_parked_bit)) == (locked_bit | lock_parked_bit);
+            });
+        }
+    }
+
+    void unlock() {
+        const uint32_t s = state.fetch_and(~locked_bit, std::memory_order_release);
+        if ((s & lock_parked_bit) != 0) {
+            parking_lot::unpark_one(lock_key(), [this](bool have_more) {
+                if (!have_more) {
+                    state.fetch_and(~lock_parked_bit, std::memory_order_relaxed);
+                }
+            });
+        }
+    }
+
+    /**
+     * @brief Holds the ring lock for a scope, like std::lock_guard over lock() / unlock().
+     *
+     * Releases the lock if an item's move assignment throws, which would
+     * otherwise leave the state word locked and hang every later operation.
+     */
+    class ring_guard {
+    public:
+        explicit ring_guard(compact_queue& queue) : queue(queue) { queue.lock(); }
+        ~ring_guard() { queue.unlock(); }
+
+        ring_guard(const ring_guard&) = delete;
+        ring_guard& operator=(const ring_guard&) = delete;
+
+    private:
+        compact_queue& queue;
+    };
+
+    /**
+     * @brief Wake one thread parked on @p key if @p parked_bit is set (lock held).
+     */
+    void wake_one(const void* key, uint32_t parked_bit) {
+        if ((state.load(std::memory_order_relaxed) & parked_bit) != 0) {
+            parking_lot::unpark_one(key, [this, parked_bit](bool have_more) {
+                if (!have_more) {
+                    state.fetch_and(~parked_bit, std::memory_order_relaxed);
+                }
+            });
+        }
+    }
+
+    /**
+     * @brief Release the lock and park on @p key until woken, closed or @p deadline.
+     *
+     * @return bool false if the deadline passed.
+     */
+    bool wait_unlocked(const void* key, uint32_t parked_bit, const parking_lot::clock::time_point* deadline) {
+        state.fetch_or(parked_bit, std::memory_order_relaxed);
+        unlock();
+        auto still_blocked = [this, parked_bit]() {
+            const uint32_t now = state.load(std::memory_order_relaxed);
+            return (now & parked_bit) != 0 && (now & closed_bit) == 0;
+        };
+        if (deadline == nullptr) {
+            parking_lot::park(key, still_blocked);
+        } else if (!parking_lot::park_until(key, still_blocked, *deadline) &&
+                   parking_lot::clock::now() >= *deadline) {
+            lock();
+            return false;
+        }
+        lock();
+        return true;
+    }
+
+    queue_status push_until(T&& item, const parking_lot::clock::time_point* deadline) {
+        ring_guard guard(*this);
+        while (count == capacity) {
+            if ((state.load(std::memory_order_relaxed) & closed_bit) != 0) {
+                break;
+            }
+            if (!wait_unlocked(producer_key(), producers_parked_bit, deadline) && count == capacity) {
+                return queue_status::timeout;
+            }
+        }
+        if ((state.load(std::memory_order_relaxed) & closed_bit) != 0) {
+            return queue_status::closed;
+        }
+        uint32_t tail = head + count;
+        if (tail >= capacity) {
+            tail -= capacity;
+        }
+        slots[tail] = std::move(item);
+        ++count;
+        wake_one(consumer_key(), consumers_parked_bit);
+        return queue_status::ok;
+    }
+
+    queue_status pop_until(T& item, const parking_lot::clock::time_point* deadline) {
+        ring_guard guard(*this);
+        while (count == 0) {
+            if ((state.load(std::memory_order_relaxed) & closed_bit) != 0) {
+                return queue_status::closed;
+            }
+            if (!wait_unlocked(consumer_key(), consumers_parked_bit, deadline) && count == 0) {
+                return queue_status::timeout;
+            }
+        }
+        item = std::move(slots[head]);
+        head = head + 1 == capacity ? 0 : head + 1;
+        --count;
+        wake_one(producer_key(), producers_parked_bit);
+        return queue_status::ok;
+    }
+
+    T* slots;                               ///< Ring buffer
+    uint32_t capacity;                      ///< Maximum number of items
+    uint32_t head = 0;                      ///< Index of the oldest item
+    uint32_t count = 0;                     ///< Items queued
+    std::atomic<uint32_t> state{0};         ///< Lock, parked and closed bits
+};
+
+#endif
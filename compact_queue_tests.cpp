@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "compact_queue.h"
+#include "parking_lot.h"
+
+TEST(ParkingLotTest, ValidationFailureDoesNotPark) {
+    int key = 0;
+    EXPECT_FALSE(parking_lot::park(&key, []() { return false; }));
+    EXPECT_FALSE(parking_lot::park_until(&key, []() { return true; },
+                                         parking_lot::clock::now() + std::chrono::milliseconds(5)));
+    EXPECT_EQ(parking_lot::unpark_all(&key), 0u);
+}
+
+TEST(ParkingLotTest, UnparkOneReportsRemainingWaiters) {
+    int key = 0;
+    std::atomic<int> woken(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 2; ++i) {
+        threads.emplace_back([&key, &woken]() {
+            EXPECT_TRUE(parking_lot::park(&key, []() { return true; }));
+            ++woken;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    bool more = false;
+    EXPECT_TRUE(parking_lot::unpark_one(&key, [&more](bool have_more) { more = have_more; }));
+    EXPECT_TRUE(more);
+    EXPECT_TRUE(parking_lot::unpark_one(&key, [&more](bool have_more) { more = have_more; }));
+    EXPECT_FALSE(more);
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(woken, 2);
+}
+
+TEST(CompactQueueTest, IsFewWords) {
+    static_assert(sizeof(compact_queue<int>) <= 3 * sizeof(void*), "compact_queue should stay a few words");
+    compact_queue<int> q(2);
+    EXPECT_EQ(q.push(1), queue_status::ok);
+    EXPECT_EQ(q.push(2), queue_status::ok);
+    EXPECT_EQ(q.try_push(3, std::chrono::milliseconds(10)), queue_status::timeout);
+    int val = 0;
+    EXPECT_EQ(q.pop(val), queue_status::ok);
+    EXPECT_EQ(val, 1);
+    EXPECT_EQ(q.try_pop(val, std::chrono::milliseconds(10)), queue_status::ok);
+    EXPECT_EQ(val, 2);
+    EXPECT_EQ(q.try_pop(val, std::chrono::milliseconds(10)), queue_status::timeout);
+}
+
+TEST(CompactQueueTest, CloseWakesParkedThreads) {
+    compact_queue<int> q(1);
+    std::thread consumer([&q]() {
+        int val;
+        EXPECT_EQ(q.pop(val), queue_status::ok);
+        EXPECT_EQ(q.pop(val), queue_status::closed);
+    });
+    q.push(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    q.close();
+    consumer.join();
+    EXPECT_EQ(q.push(2), queue_status::closed);
+}
+
+#ifndef SAFE_QUEUE_NO_EXCEPTIONS
+namespace {
+
+/// Move assignment throws while fail is set
+struct throwing_item {
+    static bool fail;
+    int value = 0;
+
+    throwing_item() = default;
+    explicit throwing_item(int v) : value(v) {}
+    throwing_item(throwing_item&&) = default;
+    throwing_item& operator=(throwing_item&& other) {
+        if (fail) {
+            throw std::runtime_error("move failed");
+        }
+        value = other.value;
+        return *this;
+    }
+};
+
+bool throwing_item::fail = false;
+
+} // namespace
+
+TEST(CompactQueueTest, ThrowingMoveReleasesTheLock) {
+    compact_queue<throwing_item> q(2);
+    throwing_item::fail = true;
+    EXPECT_THROW(q.push(throwing_item(1)), std::runtime_error);
+    throwing_item::fail = false;
+    EXPECT_EQ(q.size(), 0u);
+    EXPECT_EQ(q.push(throwing_item(2)), queue_status::ok);
+
+    throwing_item out;
+    throwing_item::fail = true;
+    EXPECT_THROW(q.pop(out), std::runtime_error);
+    throwing_item::fail = false;
+    EXPECT_EQ(q.pop(out), queue_status::ok);
+    EXPECT_EQ(out.value, 2);
+}
+#endif
+
+TEST(CompactQueueTest, ManyProducersAndConsumers) {
+    compact_queue<int> q(8);
+    const int producers = 4;
+    const int consumers = 4;
+    const int items_per_producer = 20000;
+    std::atomic<long> sum(0);
+    std::atomic<int> received(0);
+    std::vector<std::thread> threads;
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&]() {
+            int val;
+            while (q.pop(val) == queue_status::ok) {
+                sum += val;
+                ++received;
+            }
+        });
+    }
+    std::vector<std::thread> producer_threads;
+    for (int p = 0; p < producers; ++p) {
+        producer_threads.emplace_back([&]() {
+            for (int i = 1; i <= items_per_producer; ++i) {
+                ASSERT_EQ(q.push(i), queue_status::ok);
+            }
+        });
+    }
+    for (auto& t : producer_threads) {
+        t.join();
+    }
+    q.close();
+    for (auto& t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(received, producers * items_per_producer);
+    EXPECT_EQ(sum, static_cast<long>(producers) * items_per_producer * (items_per_producer + 1) / 2);
+}
@@ -7,46 +7,163 @@
  * @brief Construct a new safe queue object.
  * 
  * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
  * @param max_capacity The maximum number of elements the queue can hold.
  */
-template <typename T>
-safe_queue<T>::safe_queue(size_t max_capacity) 
-    : maximum_capacity(max_capacity), current_size(0), first(0), last(0) {
-    queue_data = new T[maximum_capacity];
+template <typename T, typename Clock>
+safe_queue<T, Clock>::safe_queue(size_t max_capacity) 
+    : safe_queue(max_capacity, queue_storage::eager) {
+}
+
+/**
+ * @brief Construct a new safe queue object with the given buffer allocation.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param max_capacity The maximum number of elements the queue can hold.
+ * @param storage queue_storage::lazy to commit the buffer as it is used.
+ */
+template <typename T, typename Clock>
+safe_queue<T, Clock>::safe_queue(size_t max_capacity, queue_storage storage) 
+    : safe_queue(max_capacity, queue_order::fifo, storage) {
+}
+
+/**
+ * @brief Construct a new safe queue object that pops in the given order.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param max_capacity The maximum number of elements the queue can hold.
+ * @param pop_order Which queued item each pop serves.
+ * @param storage queue_storage::lazy to commit the buffer as it is used.
+ * 
+ * If the address space cannot be reserved, lazy storage falls back to eager;
+ * a capacity whose size in bytes overflows size_t is never reserved, so the
+ * eager allocation rejects it with std::bad_array_new_length.
+ */
+template <typename T, typename Clock>
+safe_queue<T, Clock>::safe_queue(size_t max_capacity, queue_order pop_order, queue_storage storage) 
+    : maximum_capacity(max_capacity), active_slots(max_capacity), initial_slots(max_capacity),
+      lazy_storage(false), current_size(0), first(0), last(0), closed_flag(false), order(pop_order),
+      push_sequence(0), relocations(0), tombstones(0) {
+    if (storage == queue_storage::lazy && maximum_capacity > 0 && maximum_capacity <= SIZE_MAX / sizeof(T)) {
+        void* region = ring_memory::reserve(maximum_capacity * sizeof(T));
+        if (region != nullptr) {
+            queue_data = static_cast<T*>(region);
+            initial_slots = std::min(maximum_capacity, std::max<size_t>(1, ring_memory::page_size() / sizeof(T)));
+#ifdef __cpp_exceptions
+            try {
+                construct_slots(0, initial_slots);
+            } catch (...) {
+                ring_memory::release(region, maximum_capacity * sizeof(T));
+                throw;
+            }
+#else
+            construct_slots(0, initial_slots);
+#endif
+            lazy_storage = true;
+            active_slots = initial_slots;
+        }
+    }
+    if (!lazy_storage) {
+        queue_data = new T[maximum_capacity];
+    }
+    slot_tags.assign(active_slots, 0);
+    counters_data.capacity.store(maximum_capacity, std::memory_order_relaxed);
 }
 
 /**
  * @brief Destroy the safe queue object.
  * 
  * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
  */
-template <typename T>
-safe_queue<T>::~safe_queue() {
-    delete[] queue_data;
+template <typename T, typename Clock>
+safe_queue<T, Clock>::~safe_queue() {
+    if (lazy_storage) {
+        for (size_t i = 0; i < active_slots; ++i) {
+            queue_data[i].~T();
+        }
+        ring_memory::release(queue_data, maximum_capacity * sizeof(T));
+    } else {
+        delete[] queue_data;
+    }
+}
+
+/**
+ * @brief Get the number of slots currently constructed.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @return size_t The slots the ring cycles through.
+ */
+template <typename T, typename Clock>
+size_t safe_queue<T, Clock>::committed_capacity() const {
+    locked_scope scope(*this);
+    return active_slots;
+}
+
+/**
+ * @brief Release the slots a lazy ring no longer needs.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ */
+template <typename T, typename Clock>
+void safe_queue<T, Clock>::shrink_to_fit() {
+    locked_scope scope(*this);
+    if (!lazy_storage) {
+        return;
+    }
+    size_t target = initial_slots;
+    while (target < current_size) {
+        target = std::min(maximum_capacity, target * 2);
+    }
+    if (target >= active_slots) {
+        return;
+    }
+    
+    // Move the items to the front so the tail slots are free.
+    std::rotate(queue_data, queue_data + first, queue_data + active_slots);
+    std::rotate(slot_tags.begin(), slot_tags.begin() + first, slot_tags.end());
+    slot_tags.resize(target);
+    ++relocations;
+    for (size_t i = target; i < active_slots; ++i) {
+        queue_data[i].~T();
+    }
+    ring_memory::discard(queue_data + target, (active_slots - target) * sizeof(T));
+    active_slots = target;
+    first = 0;
+    last = current_size % active_slots;
 }
 
 /**
  * @brief Get the current number of elements in the queue.
  * 
  * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
  * @return size_t The number of elements currently in the queue.
  */
-template <typename T>
-size_t safe_queue<T>::size() const {
-    std::lock_guard<std::mutex> lock(mutex_sync);
-    return current_size;
+template <typename T, typename Clock>
+size_t safe_queue<T, Clock>::size() const {
+    locked_scope scope(*this);
+    return current_size - tombstones;
 }
 
 /**
  * @brief Check if the queue is empty.
  * 
  * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
  * @return true If the queue is empty.
  * @return false If the queue contains elements.
+ * 
+ * Agrees with size(): tombstones are reclaimed once they reach either end,
+ * so a queue of only cancelled items has none left.
  */
-template <typename T>
-bool safe_queue<T>::empty() const {
-    std::lock_guard<std::mutex> lock(mutex_sync);
+template <typename T, typename Clock>
+bool safe_queue<T, Clock>::empty() const {
+    locked_scope scope(*this);
     return current_size == 0;
 }
 
@@ -54,100 +171,792 @@ bool safe_queue<T>::empty() const {
  * @brief Check if the queue is full.
  * 
  * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
  * @return true If the queue has reached maximum capacity.
  * @return false If the queue can accept more elements.
+ * 
+ * Cancelled items not yet reclaimed still occupy their slots, so a full
+ * queue may have size() below the capacity.
  */
-template <typename T>
-bool safe_queue<T>::full() const {
-    std::lock_guard<std::mutex> lock(mutex_sync);
+template <typename T, typename Clock>
+bool safe_queue<T, Clock>::full() const {
+    locked_scope scope(*this);
     return current_size == maximum_capacity;
 }
 
+/**
+ * @brief Check if the queue has been closed.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @return true If close() has been called.
+ * @return false If the queue accepts pushes.
+ */
+template <typename T, typename Clock>
+bool safe_queue<T, Clock>::closed() const {
+    locked_scope scope(*this);
+    return closed_flag;
+}
+
+/**
+ * @brief Close the queue and wake every blocked producer and consumer.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ */
+template <typename T, typename Clock>
+void safe_queue<T, Clock>::close() {
+    locked_scope scope(*this);
+    if (closed_flag) {
+        return;
+    }
+    closed_flag = true;
+    SAFE_QUEUE_PROBE2(close, probe_id(), current_size);
+    
+    is_full.notify_all();
+    is_empty.notify_all();
+}
+
 /**
  * @brief Push an item into the queue (blocking).
  * 
  * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
  * @param item The item to push into the queue.
+ * @return queue_handle Refers to the pushed item; empty if it was dropped.
+ * @throws std::runtime_error If the queue is closed.
  */
-template <typename T>
-void safe_queue<T>::push(const T& item) {
-    std::unique_lock<std::mutex> lock(mutex_sync);
-    is_full.wait(lock, [this]() { return current_size < maximum_capacity; });
+template <typename T, typename Clock>
+queue_handle safe_queue<T, Clock>::push(const T& item) {
+    queue_handle handle;
+    if (wait_push(item, handle) == queue_status::ok) {
+        return handle;
+    }
+#ifndef SAFE_QUEUE_NO_EXCEPTIONS
+    throw std::runtime_error("Push failed - queue is closed");
+#else
+    return handle;
+#endif
+}
+
+/**
+ * @brief Push an item into the queue, blocking until it is pushed or the queue is closed.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param item The item to push into the queue.
+ * @return queue_status::ok If the item was pushed.
+ * @return queue_status::closed If the queue was closed before space became available.
+ */
+template <typename T, typename Clock>
+queue_status safe_queue<T, Clock>::wait_push(const T& item) {
+    queue_handle handle;
+    return wait_push(item, handle);
+}
+
+/**
+ * @brief Push an item, blocking until it is pushed or the queue is closed, and return its handle.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param item The item to push into the queue.
+ * @param handle Receives the handle of the pushed item, for cancel().
+ * @return queue_status::ok If the item was pushed.
+ * @return queue_status::closed If the queue was closed before space became available.
+ */
+template <typename T, typename Clock>
+queue_status safe_queue<T, Clock>::wait_push(const T& item, queue_handle& handle) {
+    const uint64_t arrival_ns = trace_arrival();
+    locked_scope scope(*this);
+    await_locked(is_full, scope.lock,
+                 [this]() { return closed_flag || current_size < maximum_capacity; }, producer_side);
+    if (closed_flag) {
+        return queue_status::closed;
+    }
     
-    queue_data[last] = item;
-    last = (last + 1) % maximum_capacity;
-    ++current_size;
+    handle = enqueue_locked(item);
+    trace_push(arrival_ns);
+    return queue_status::ok;
+}
+
+/**
+ * @brief Cancel a queued item so no pop returns it.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param handle The handle returned when the item was pushed.
+ * @return bool true if the item was still queued and is now cancelled.
+ */
+template <typename T, typename Clock>
+bool safe_queue<T, Clock>::cancel(const queue_handle& handle) {
+    if (!handle) {
+        return false;
+    }
+    locked_scope scope(*this);
+    size_t slot = handle.slot;
+    if (handle.layout != relocations) {
+        slot = find_locked(handle.id);
+        if (slot == active_slots) {
+            return false;
+        }
+    } else if ((slot_tags[slot] >> 1) != handle.id) {
+        return false;
+    }
+    if ((slot_tags[slot] & 1) != 0) {
+        return false;
+    }
     
+    slot_tags[slot] |= 1;
+    ++tombstones;
+    bump_counter(counters_data.cancelled);
+    if (reclaim_cancelled_locked() == 0) {
+        publish_depth_locked();
+    }
+    return true;
+}
+
+/**
+ * @brief Push an item at the head, so it is the next one a FIFO pop serves.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param item The item to push.
+ * @return queue_status::ok If the item was pushed.
+ * @return queue_status::closed If the queue was closed before space became available.
+ */
+template <typename T, typename Clock>
+queue_status safe_queue<T, Clock>::push_front(const T& item) {
+    queue_handle handle;
+    return push_front(item, handle);
+}
+
+/**
+ * @brief Push an item at the head and return its handle.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param item The item to push.
+ * @param handle Receives the handle of the pushed item, for cancel().
+ * @return queue_status::ok If the item was pushed.
+ * @return queue_status::closed If the queue was closed before space became available.
+ */
+template <typename T, typename Clock>
+queue_status safe_queue<T, Clock>::push_front(const T& item, queue_handle& handle) {
+    const uint64_t arrival_ns = trace_arrival();
+    locked_scope scope(*this);
+    await_locked(is_full, scope.lock,
+                 [this]() { return closed_flag || current_size < maximum_capacity; }, producer_side);
+    if (closed_flag) {
+        return queue_status::closed;
+    }
+    
+    handle = store_front_locked(item);
     is_empty.notify_one();
+    trace_push(arrival_ns);
+    return queue_status::ok;
+}
+
+/**
+ * @brief Push several items in order, taking mutex_sync once per run of free slots.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param items The items to push.
+ * @param count The number of items.
+ * @return size_t The number of items pushed; less than @p count only if the queue was closed.
+ */
+template <typename T, typename Clock>
+size_t safe_queue<T, Clock>::push_batch(const T* items, size_t count) {
+    const uint64_t arrival_ns = trace_arrival();
+    locked_scope scope(*this);
+    size_t pushed = 0;
+    while (pushed < count) {
+        await_locked(is_full, scope.lock,
+                     [this]() { return closed_flag || current_size < maximum_capacity; }, producer_side);
+        if (closed_flag) {
+            break;
+        }
+        
+        const size_t run = std::min(count - pushed, maximum_capacity - current_size);
+        for (size_t i = 0; i < run; ++i) {
+            store_locked(items[pushed + i]);
+            trace_push(arrival_ns);
+        }
+        pushed += run;
+        if (run == 1) {
+            is_empty.notify_one();
+        } else {
+            is_empty.notify_all();
+        }
+    }
+    return pushed;
 }
 
 /**
  * @brief Push an item into the queue with timeout.
  * 
  * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
  * @param item The item to push into the queue.
  * @param timeout Maximum time to wait for space to become available.
  * @return true If the item was successfully pushed.
- * @throws std::runtime_error If the timeout expires before space becomes available.
+ * @return false If the timeout expired or the queue is closed (SAFE_QUEUE_NO_EXCEPTIONS builds only).
+ * @throws std::runtime_error If the timeout expires before space becomes available
+ *         or the queue is closed.
  */
-template <typename T>
-bool safe_queue<T>::push(const T& item, const std::chrono::milliseconds& timeout) {
-    std::unique_lock<std::mutex> lock(mutex_sync);
-    
-    if (!is_full.wait_for(lock, timeout, [this]() { return current_size < maximum_capacity; })) {
-        throw std::runtime_error("Push timeout - queue is full");
+template <typename T, typename Clock>
+bool safe_queue<T, Clock>::push(const T& item, const std::chrono::milliseconds& timeout) {
+    const queue_status status = try_push(item, timeout);
+    if (status == queue_status::ok) {
+        return true;
     }
+#ifdef SAFE_QUEUE_NO_EXCEPTIONS
+    return false;
+#else
+    throw std::runtime_error(status == queue_status::closed ? "Push failed - queue is closed"
+                                                            : "Push timeout - queue is full");
+#endif
+}
+
+/**
+ * @brief Push an item into the queue with timeout, without throwing.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param item The item to push into the queue.
+ * @param timeout Maximum time to wait for space to become available.
+ * @return queue_status::ok If the item was pushed.
+ * @return queue_status::timeout If the timeout expired before space became available.
+ * @return queue_status::closed If the queue is closed.
+ */
+template <typename T, typename Clock>
+queue_status safe_queue<T, Clock>::try_push(const T& item, const std::chrono::milliseconds& timeout) {
+    const uint64_t arrival_ns = trace_arrival();
+    locked_scope scope(*this);
     
-    queue_data[last] = item;
-    last = (last + 1) % maximum_capacity;
-    ++current_size;
+    const typename Clock::time_point deadline = Clock::now() + timeout;
+    if (!await_until_locked(is_full, scope.lock,
+                            [this]() { return closed_flag || current_size < maximum_capacity; },
+                            deadline, producer_side)) {
+        return queue_status::timeout;
+    }
+    if (closed_flag) {
+        return queue_status::closed;
+    }
     
-    is_empty.notify_one();
-    return true;
+    enqueue_locked(item);
+    trace_push(arrival_ns);
+    return queue_status::ok;
 }
 
 /**
  * @brief Pop an item from the queue (blocking).
  * 
  * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
  * @return T The popped item.
+ * @throws std::runtime_error If the queue is closed and empty.
  */
-template <typename T>
-T safe_queue<T>::pop() {
-    std::unique_lock<std::mutex> lock(mutex_sync);
-    is_empty.wait(lock, [this]() { return current_size > 0; });
+template <typename T, typename Clock>
+T safe_queue<T, Clock>::pop() {
+    locked_scope scope(*this);
+    await_locked(is_empty, scope.lock, [this]() { return closed_flag || current_size > 0; }, consumer_side);
+    if (current_size == 0) {
+#ifdef SAFE_QUEUE_NO_EXCEPTIONS
+        return T();
+#else
+        throw std::runtime_error("Pop failed - queue is closed");
+#endif
+    }
     
-    T item = queue_data[first];
-    first = (first + 1) % maximum_capacity;
-    --current_size;
+    T item = dequeue_locked();
+    trace_pop();
+    return item;
+}
+
+/**
+ * @brief Pop an item from the queue, blocking until one is available or the queue is closed and empty.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param item Reference to store the popped item.
+ * @return queue_status::ok If an item was popped into @p item.
+ * @return queue_status::closed If the queue is closed and has been drained.
+ */
+template <typename T, typename Clock>
+queue_status safe_queue<T, Clock>::wait_pop(T& item) {
+    locked_scope scope(*this);
+    await_locked(is_empty, scope.lock, [this]() { return closed_flag || current_size > 0; }, consumer_side);
+    if (current_size == 0) {
+        return queue_status::closed;
+    }
+    
+    item = dequeue_locked();
+    trace_pop();
+    return queue_status::ok;
+}
+
+/**
+ * @brief Pop the newest item, blocking until one is available or the queue is closed and empty.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param item Reference to store the popped item.
+ * @return queue_status::ok If an item was popped into @p item.
+ * @return queue_status::closed If the queue is closed and has been drained.
+ */
+template <typename T, typename Clock>
+queue_status safe_queue<T, Clock>::pop_back(T& item) {
+    locked_scope scope(*this);
+    await_locked(is_empty, scope.lock, [this]() { return closed_flag || current_size > 0; }, consumer_side);
+    if (current_size == 0) {
+        return queue_status::closed;
+    }
     
+    item = take_end_locked(true);
     is_full.notify_one();
-    return item;
+    trace_pop();
+    return queue_status::ok;
 }
 
 /**
  * @brief Pop an item from the queue with timeout.
  * 
  * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
  * @param item Reference to store the popped item.
  * @param timeout Maximum time to wait for an item to become available.
  * @return true If an item was successfully popped.
- * @throws std::runtime_error If the timeout expires before an item becomes available.
+ * @return false If the timeout expired or the queue is closed and empty
+ *         (SAFE_QUEUE_NO_EXCEPTIONS builds only).
+ * @throws std::runtime_error If the timeout expires before an item becomes available
+ *         or the queue is closed and empty.
  */
-template <typename T>
-bool safe_queue<T>::pop(T& item, const std::chrono::milliseconds& timeout) {
-    std::unique_lock<std::mutex> lock(mutex_sync);
+template <typename T, typename Clock>
+bool safe_queue<T, Clock>::pop(T& item, const std::chrono::milliseconds& timeout) {
+    const queue_status status = try_pop(item, timeout);
+    if (status == queue_status::ok) {
+        return true;
+    }
+#ifdef SAFE_QUEUE_NO_EXCEPTIONS
+    return false;
+#else
+    throw std::runtime_error(status == queue_status::closed ? "Pop failed - queue is closed"
+                                                            : "Pop timeout - queue is empty");
+#endif
+}
+
+/**
+ * @brief Pop an item from the queue with timeout, without throwing.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param item Reference to store the popped item.
+ * @param timeout Maximum time to wait for an item to become available.
+ * @return queue_status::ok If an item was popped into @p item.
+ * @return queue_status::timeout If the timeout expired before an item became available.
+ * @return queue_status::closed If the queue is closed and has been drained.
+ */
+template <typename T, typename Clock>
+queue_status safe_queue<T, Clock>::try_pop(T& item, const std::chrono::milliseconds& timeout) {
+    locked_scope scope(*this);
     
-    if (!is_empty.wait_for(lock, timeout, [this]() { return current_size > 0; })) {
-        throw std::runtime_error("Pop timeout - queue is empty");
+    const typename Clock::time_point deadline = Clock::now() + timeout;
+    if (!await_until_locked(is_empty, scope.lock, [this]() { return closed_flag || current_size > 0; },
+                            deadline, consumer_side)) {
+        return queue_status::timeout;
+    }
+    if (current_size == 0) {
+        return queue_status::closed;
     }
     
-    item = queue_data[first];
-    first = (first + 1) % maximum_capacity;
-    --current_size;
+    item = dequeue_locked();
+    trace_pop();
+    return queue_status::ok;
+}
+
+/**
+ * @brief Pop up to max_items items under one acquisition of mutex_sync.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param out Receives the items, appended in the order successive pops would return them.
+ * @param max_items The maximum number of items to take.
+ * @param max_wait How long to wait for the first item.
+ * @return queue_status ok, timeout or closed; see the declaration.
+ */
+template <typename T, typename Clock>
+queue_status safe_queue<T, Clock>::pop_batch(std::vector<T>& out, size_t max_items,
+                                             const std::chrono::milliseconds& max_wait) {
+    locked_scope scope(*this);
+    if (max_items == 0) {
+        return closed_flag && current_size == 0 ? queue_status::closed : queue_status::ok;
+    }
     
+    const typename Clock::time_point deadline = Clock::now() + max_wait;
+    if (!await_until_locked(is_empty, scope.lock, [this]() { return closed_flag || current_size > 0; },
+                            deadline, consumer_side)) {
+        return queue_status::timeout;
+    }
+    if (current_size == 0) {
+        return queue_status::closed;
+    }
+    
+    // Taking an item can reclaim cancelled ones behind it, so re-check the size each time
+    size_t run = 0;
+    out.reserve(out.size() + std::min(max_items, current_size - tombstones));
+    while (run < max_items && current_size > 0) {
+        out.push_back(take_locked());
+        trace_pop();
+        ++run;
+    }
+    if (run == 1) {
+        is_full.notify_one();
+    } else {
+        is_full.notify_all();
+    }
+    return queue_status::ok;
+}
+
+/**
+ * @brief Construct lazy ring slots [from, to), destroying them again if a constructor throws.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param from The first slot to construct.
+ * @param to One past the last slot to construct.
+ * 
+ * Either every slot is constructed or, if T() throws, none is left
+ * constructed and the exception propagates with the ring unchanged.
+ */
+template <typename T, typename Clock>
+void safe_queue<T, Clock>::construct_slots(size_t from, size_t to) {
+    size_t i = from;
+#ifdef __cpp_exceptions
+    try {
+        for (; i < to; ++i) {
+            new (queue_data + i) T();
+        }
+    } catch (...) {
+        while (i > from) {
+            queue_data[--i].~T();
+        }
+        throw;
+    }
+#else
+    for (; i < to; ++i) {
+        new (queue_data + i) T();
+    }
+#endif
+}
+
+/**
+ * @brief Double the active slots of a full lazy ring.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @pre mutex_sync is held, storage is lazy, and the ring is full but below
+ *      maximum_capacity.
+ * 
+ * New slots are constructed in fresh pages at the end of the ring. The items
+ * from first to the old end move up to the new end, so the ring order is
+ * kept and the free slots lie between last and first. If allocating the
+ * tags or constructing the new slots throws, the ring is left unchanged.
+ */
+template <typename T, typename Clock>
+void safe_queue<T, Clock>::grow_locked() {
+    const size_t grown = std::min(maximum_capacity, active_slots * 2);
+    // Size the tags first: a failed allocation then leaves no slots
+    // constructed, and a throwing T() only leaves unused zero tags behind
+    slot_tags.resize(grown, 0);
+    construct_slots(active_slots, grown);
+    if (first == 0) {
+        last = active_slots;
+    } else {
+        const size_t moved_from = first;
+        std::move_backward(queue_data + first, queue_data + active_slots, queue_data + grown);
+        std::move_backward(slot_tags.begin() + first, slot_tags.begin() + active_slots, slot_tags.end());
+        first += grown - active_slots;
+        std::fill(slot_tags.begin() + moved_from, slot_tags.begin() + first, 0);
+        ++relocations;
+    }
+    active_slots = grown;
+}
+
+/**
+ * @brief Store an item at the tail without waking anyone.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param item The item to store.
+ * @pre mutex_sync is held and the queue is not full.
+ */
+template <typename T, typename Clock>
+queue_handle safe_queue<T, Clock>::store_locked(const T& item) {
+    if (current_size == active_slots) {
+        grow_locked();
+    }
+    const queue_handle handle{last, ++push_sequence, relocations};
+    queue_data[last] = item;
+    slot_tags[last] = handle.id << 1;
+    last = (last + 1) % active_slots;
+    ++current_size;
+    bump_counter(counters_data.pushes);
+    publish_depth_locked();
+    SAFE_QUEUE_PROBE2(push, probe_id(), current_size);
+    return handle;
+}
+
+/**
+ * @brief Store an item at the tail and wake one consumer.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param item The item to store.
+ * @pre mutex_sync is held and the queue is not full.
+ */
+template <typename T, typename Clock>
+queue_handle safe_queue<T, Clock>::enqueue_locked(const T& item) {
+    const queue_handle handle = store_locked(item);
+    is_empty.notify_one();
+    return handle;
+}
+
+/**
+ * @brief Store an item at the head without waking anyone.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param item The item to store.
+ * @pre mutex_sync is held and the queue is not full.
+ * 
+ * The free slots of the ring lie between last and first, also after
+ * grow_locked(), so the slot before first is always free.
+ */
+template <typename T, typename Clock>
+queue_handle safe_queue<T, Clock>::store_front_locked(const T& item) {
+    if (current_size == active_slots) {
+        grow_locked();
+    }
+    first = (first == 0 ? active_slots : first) - 1;
+    const queue_handle handle{first, ++push_sequence, relocations};
+    queue_data[first] = item;
+    slot_tags[first] = handle.id << 1;
+    ++current_size;
+    bump_counter(counters_data.pushes);
+    publish_depth_locked();
+    SAFE_QUEUE_PROBE2(push, probe_id(), current_size);
+    return handle;
+}
+
+/**
+ * @brief Check whether the next pop serves the newest item.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @return bool true for LIFO order, or hybrid order with a backlog of at most half the capacity.
+ * @pre mutex_sync is held.
+ */
+template <typename T, typename Clock>
+bool safe_queue<T, Clock>::serve_newest_locked() const {
+    switch (order) {
+    case queue_order::lifo:
+        return true;
+    case queue_order::hybrid:
+        return current_size * 2 <= maximum_capacity;
+    case queue_order::fifo:
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Remove the newest or the oldest item without waking anyone.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param newest true to take the tail, false to take the head.
+ * @return T The removed item.
+ * @pre mutex_sync is held and the queue is not empty.
+ */
+template <typename T, typename Clock>
+T safe_queue<T, Clock>::take_end_locked(bool newest) {
+    T item;
+    if (newest) {
+        last = (last == 0 ? active_slots : last) - 1;
+        item = queue_data[last];
+        slot_tags[last] = 0;
+    } else {
+        item = queue_data[first];
+        slot_tags[first] = 0;
+        first = (first + 1) % active_slots;
+    }
+    --current_size;
+    bump_counter(counters_data.pops);
+    publish_depth_locked();
+    SAFE_QUEUE_PROBE2(pop, probe_id(), current_size);
+    reclaim_cancelled_locked();
+    return item;
+}
+
+/**
+ * @brief Remove the next item in queue_order without waking anyone.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @return T The removed item.
+ * @pre mutex_sync is held and the queue is not empty.
+ */
+template <typename T, typename Clock>
+T safe_queue<T, Clock>::take_locked() {
+    return take_end_locked(serve_newest_locked());
+}
+
+/**
+ * @brief Free the cancelled items at both ends of the ring.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @return size_t The number of slots freed.
+ * @pre mutex_sync is held.
+ * 
+ * Each tombstone is freed once, so the cost is amortized O(1) per cancel.
+ */
+template <typename T, typename Clock>
+size_t safe_queue<T, Clock>::reclaim_cancelled_locked() {
+    size_t reclaimed = 0;
+    while (tombstones > 0 && (slot_tags[first] & 1) != 0) {
+        slot_tags[first] = 0;
+        queue_data[first] = T();
+        first = (first + 1) % active_slots;
+        --current_size;
+        --tombstones;
+        ++reclaimed;
+    }
+    while (tombstones > 0) {
+        const size_t tail = (last == 0 ? active_slots : last) - 1;
+        if ((slot_tags[tail] & 1) == 0) {
+            break;
+        }
+        slot_tags[tail] = 0;
+        queue_data[tail] = T();
+        last = tail;
+        --current_size;
+        --tombstones;
+        ++reclaimed;
+    }
+    if (reclaimed > 0) {
+        publish_depth_locked();
+        is_full.notify_all();
+    }
+    return reclaimed;
+}
+
+/**
+ * @brief Find the slot of the queued item with the given push sequence number.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @param id The push sequence number from the item's handle.
+ * @return size_t The slot, or active_slots if the item is no longer queued.
+ * @pre mutex_sync is held.
+ */
+template <typename T, typename Clock>
+size_t safe_queue<T, Clock>::find_locked(uint64_t id) const {
+    for (size_t i = 0, slot = first; i < current_size; ++i) {
+        if ((slot_tags[slot] >> 1) == id) {
+            return slot;
+        }
+        slot = slot + 1 == active_slots ? 0 : slot + 1;
+    }
+    return active_slots;
+}
+
+/**
+ * @brief Remove the next item in queue_order and wake one producer.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @return T The removed item.
+ * @pre mutex_sync is held and the queue is not empty.
+ */
+template <typename T, typename Clock>
+T safe_queue<T, Clock>::dequeue_locked() {
+    T item = take_locked();
     is_full.notify_one();
-    return true;
+    return item;
+}
+
+/**
+ * @brief Block until a condition holds.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @tparam Predicate Callable returning true once the caller may proceed.
+ * @param cv The condition variable signalled when @p ready may have changed.
+ * @param lock The held lock on mutex_sync.
+ * @param ready The condition to wait for.
+ * @param side The waiting side, counted in counters_data and reported to the probes.
+ */
+template <typename T, typename Clock>
+template <typename Predicate>
+void safe_queue<T, Clock>::await_locked(queue_condition& cv,
+                                        std::unique_lock<std::mutex>& lock,
+                                        Predicate ready,
+                                        wait_side side) {
+    if (ready()) {
+        return;
+    }
+    
+    SAFE_QUEUE_PROBE3(block_start, probe_id(), current_size, static_cast<int>(side));
+    profile_hold_end();
+    const auto blocked_at = std::chrono::steady_clock::now();
+    counted_wait(cv, lock, ready, counters_data, side);
+    const auto waited = std::chrono::steady_clock::now() - blocked_at;
+    profile_hold_start();
+    SAFE_QUEUE_PROBE4(block_end, probe_id(), current_size, static_cast<int>(side),
+                      std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count());
+    (void)waited;
+}
+
+/**
+ * @brief Block until a condition holds or a deadline passes.
+ * 
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations.
+ * @tparam Predicate Callable returning true once the caller may proceed.
+ * @param cv The condition variable signalled when @p ready may have changed.
+ * @param lock The held lock on mutex_sync.
+ * @param ready The condition to wait for.
+ * @param deadline When to give up, on the Clock policy's time line.
+ * @param side The waiting side, counted in counters_data and reported to the probes.
+ * @return true If @p ready holds.
+ * @return false If the deadline passed first.
+ */
+template <typename T, typename Clock>
+template <typename Predicate>
+bool safe_queue<T, Clock>::await_until_locked(queue_condition& cv,
+                                              std::unique_lock<std::mutex>& lock,
+                                              Predicate ready,
+                                              typename Clock::time_point deadline,
+                                              wait_side side) {
+    if (ready()) {
+        return true;
+    }
+    
+    SAFE_QUEUE_PROBE3(block_start, probe_id(), current_size, static_cast<int>(side));
+    profile_hold_end();
+    const auto blocked_at = std::chrono::steady_clock::now();
+    const bool satisfied = counted_wait_until<Clock>(cv.native(), lock, ready, deadline, counters_data, side);
+    const auto waited = std::chrono::steady_clock::now() - blocked_at;
+    profile_hold_start();
+    SAFE_QUEUE_PROBE4(block_end, probe_id(), current_size, static_cast<int>(side),
+                      std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count());
+    (void)waited;
+    if (!satisfied) {
+        SAFE_QUEUE_PROBE3(timeout, probe_id(), current_size, static_cast<int>(side));
+    }
+    return satisfied;
 }
 
 #endif
\ No newline at end of file
@@ -1,15 +1,77 @@
 #ifndef ENQUEUE_H
 #define ENQUEUE_H
 
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
+#include <new>
+#include <vector>
+#include "queue_clock.h"
+#include "queue_counters.h"
+#include "queue_wait.h"
+#ifdef SAFE_QUEUE_LOCK_PROFILING
+#include "lock_profile.h"
+#endif
+#include "queue_probes.h"
+#include "ring_memory.h"
+#ifdef SAFE_QUEUE_TRACING
+#include "queue_trace.h"
+#endif
+#ifndef SAFE_QUEUE_NO_EXCEPTIONS
 #include <stdexcept>
+#endif
+
+/**
+ * @brief Result of a non-throwing queue operation.
+ *
+ * The try_* operations report every failure mode through this code instead of
+ * throwing, so they are usable from builds compiled with -fno-exceptions.
+ */
+enum class queue_status {
+    ok,         ///< The operation completed.
+    timeout,    ///< The timeout expired before the operation could complete.
+    closed      ///< The queue was closed (and, for pops, drained).
+};
+
+/**
+ * @brief How a queue allocates its ring buffer.
+ */
+enum class queue_storage {
+    eager,      ///< Allocate and construct every slot up front.
+    lazy        ///< Reserve address space; construct and commit slots as the queue grows.
+};
+
+/**
+ * @brief Refers to one pushed item, so it can be cancelled while queued.
+ * 
+ * A default-constructed handle refers to no item.
+ */
+struct queue_handle {
+    size_t slot = 0;        ///< Ring index the item was stored at
+    uint64_t id = 0;        ///< Push sequence number of the item, 0 for no item
+    uint64_t layout = 0;    ///< Ring relocations before the push; slot is stale once this changes
+
+    /// Check if the handle refers to an item
+    explicit operator bool() const { return id != 0; }
+};
+
+/**
+ * @brief Which queued item a pop serves.
+ */
+enum class queue_order {
+    fifo,       ///< The oldest item.
+    lifo,       ///< The newest item, whose data is most likely still in cache.
+    hybrid      ///< The newest while at most half full, the oldest beyond that.
+};
 
 /**
  * @brief A thread-safe queue implementation with fixed capacity and timeout support.
  * 
  * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used by the timed operations (see queue_clock.h);
+ *         virtual_clock makes timeouts instant and deterministic in tests.
  * 
  * This class provides a thread-safe FIFO queue with the following features:
  * - Fixed maximum capacity
@@ -17,18 +79,219 @@
  * - Timeout support for push and pop operations
  * - Thread-safe size checking
  * - Exception safety
+ * - Closing, which fails pushes and lets consumers drain the remaining items
+ * - push_front() and pop_back(), so retried items can skip the backlog
+ * - O(1) cancellation of queued items through the handle push() returns
+ *
+ * With queue_storage::lazy the ring starts with about one page of slots and
+ * doubles, up to the maximum capacity, whenever it fills. Slots are carved
+ * from an address-space reservation (see ring_memory.h), so construction is
+ * O(1 page) and resident memory follows the high-water mark rather than the
+ * capacity; shrink_to_fit() returns memory after a burst.
+ *
+ * queue_order::lifo serves the most recently pushed item instead, which
+ * suits task handoff where the newest task's data is still cache-hot, but can
+ * starve old items under sustained load. queue_order::hybrid bounds that:
+ * it serves LIFO while the backlog is at most half the capacity and FIFO
+ * beyond, so a growing backlog is drained oldest first.
+ *
+ * cancel() marks an item as a tombstone in O(1) through the slot and push
+ * sequence number recorded in its queue_handle. Tombstones are reclaimed as
+ * soon as they reach either end of the ring, so pops never return them and
+ * a non-empty queue always has a live item at both ends. A tombstone in the
+ * middle keeps its slot until then; size() excludes it. Only when a lazy ring
+ * has relocated its items since the push does cancel() search for the item.
+ *
+ * Called on a fiber (see fiber.h), the untimed blocking operations park the
+ * fiber instead of blocking its worker thread, and the push or pop that
+ * makes progress possible resumes it, so fibers and threads can share a
+ * queue. The timed operations still block the worker.
+ *
+ * Defining SAFE_QUEUE_NO_EXCEPTIONS (CMake option ENQUEUE_NO_EXCEPTIONS) makes the
+ * timed overloads return false on timeout instead of throwing.
+ *
+ * Defining SAFE_QUEUE_TRACING (CMake option ENQUEUE_TRACING) records push
+ * arrivals and pop completions into queue_trace while tracing is enabled.
+ *
+ * Defining SAFE_QUEUE_USDT (CMake option ENQUEUE_USDT) exposes USDT probes for
+ * bpftrace; see queue_probes.h.
+ *
+ * Defining SAFE_QUEUE_LOCK_PROFILING (CMake option ENQUEUE_LOCK_PROFILING)
+ * records how long each operation waits for and holds mutex_sync; see
+ * lock_stats().
  */
-template <typename T>
+template <typename T, typename Clock = steady_clock_policy>
 class safe_queue {
 private:
     T* queue_data;                          ///< Dynamic array to store elements
     size_t maximum_capacity;                ///< Maximum capacity of the queue
+    size_t active_slots;                    ///< Constructed slots the ring currently cycles through
+    size_t initial_slots;                   ///< Slots constructed up front (lazy storage)
+    bool lazy_storage;                      ///< queue_data is a ring_memory reservation
     size_t current_size;                    ///< Current number of elements
     size_t first;                           ///< Index of the first element
     size_t last;                            ///< Index where next element will be inserted
+    bool closed_flag;                       ///< Set once by close()
+    queue_order order;                      ///< Which end pops serve
+    std::vector<uint64_t> slot_tags;        ///< Per slot: push sequence << 1 | cancelled bit, 0 if free
+    uint64_t push_sequence;                 ///< Sequence number of the latest push
+    uint64_t relocations;                   ///< Times grow_locked() or shrink_to_fit() moved items
+    size_t tombstones;                      ///< Cancelled items still occupying slots
     mutable std::mutex mutex_sync;          ///< Mutex for synchronization
-    std::condition_variable is_full;        ///< Condition variable for push operations
-    std::condition_variable is_empty;       ///< Condition variable for pop operations
+    queue_condition is_full;                ///< Condition variable for push operations
+    queue_condition is_empty;               ///< Condition variable for pop operations
+    queue_counters counters_data;           ///< Lock-free activity counters for monitoring
+#ifdef SAFE_QUEUE_TRACING
+    uint32_t trace_id = queue_trace::next_queue_id(); ///< Queue id used in trace events
+#endif
+
+#ifdef SAFE_QUEUE_LOCK_PROFILING
+    mutable lock_profile lock_data;                             ///< Mutex wait and hold histograms
+    mutable std::chrono::steady_clock::time_point hold_since;   ///< When the current holder took mutex_sync
+
+    /**
+     * @brief Owns mutex_sync for one operation and records acquire and hold times.
+     *
+     * The destructor body runs before the lock member is destroyed, so the
+     * hold time ends just before the mutex is released.
+     */
+    struct locked_scope {
+        const safe_queue& queue;
+        std::chrono::steady_clock::time_point requested;
+        std::unique_lock<std::mutex> lock;
+
+        explicit locked_scope(const safe_queue& q)
+            : queue(q), requested(std::chrono::steady_clock::now()), lock(q.mutex_sync) {
+            queue.profile_hold_start();
+            queue.lock_data.acquire_wait.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(queue.hold_since - requested).count()));
+        }
+
+        ~locked_scope() {
+            queue.profile_hold_end();
+        }
+    };
+
+    void profile_hold_start() const {
+        hold_since = std::chrono::steady_clock::now();
+    }
+
+    void profile_hold_end() const {
+        lock_data.hold.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - hold_since).count()));
+    }
+#else
+    /**
+     * @brief Owns mutex_sync for one operation.
+     */
+    struct locked_scope {
+        std::unique_lock<std::mutex> lock;
+
+        explicit locked_scope(const safe_queue& q) : lock(q.mutex_sync) {}
+    };
+
+    void profile_hold_start() const {}
+    void profile_hold_end() const {}
+#endif
+
+    static constexpr wait_side producer_side = wait_side::producer;  ///< Waiter is a producer waiting for space
+    static constexpr wait_side consumer_side = wait_side::consumer;  ///< Waiter is a consumer waiting for an item
+
+    /// Identifies the queue in USDT probes
+    uintptr_t probe_id() const { return reinterpret_cast<uintptr_t>(this); }
+
+    /**
+     * @brief Block on @p cv until @p ready holds (mutex_sync held).
+     */
+    template <typename Predicate>
+    void await_locked(queue_condition& cv, std::unique_lock<std::mutex>& lock,
+                      Predicate ready, wait_side side);
+
+    /**
+     * @brief Block on @p cv until @p ready holds or @p deadline passes (mutex_sync held).
+     */
+    template <typename Predicate>
+    bool await_until_locked(queue_condition& cv, std::unique_lock<std::mutex>& lock,
+                            Predicate ready, typename Clock::time_point deadline, wait_side side);
+
+    /**
+     * @brief Construct lazy ring slots [from, to), destroying them again if a constructor throws.
+     */
+    void construct_slots(size_t from, size_t to);
+
+    /**
+     * @brief Double the active slots of a full lazy ring (mutex_sync held).
+     */
+    void grow_locked();
+
+    /**
+     * @brief Store an item at the tail without waking anyone (mutex_sync held).
+     */
+    queue_handle store_locked(const T& item);
+
+    /**
+     * @brief Store an item at the tail and wake one consumer (mutex_sync held).
+     */
+    queue_handle enqueue_locked(const T& item);
+
+    /**
+     * @brief Store an item at the head without waking anyone (mutex_sync held).
+     */
+    queue_handle store_front_locked(const T& item);
+
+    /**
+     * @brief Check whether the next pop serves the newest item (mutex_sync held).
+     */
+    bool serve_newest_locked() const;
+
+    /**
+     * @brief Remove the newest or the oldest item without waking anyone (mutex_sync held).
+     */
+    T take_end_locked(bool newest);
+
+    /**
+     * @brief Remove the next item in queue_order without waking anyone (mutex_sync held).
+     */
+    T take_locked();
+
+    /**
+     * @brief Free the cancelled items at both ends of the ring (mutex_sync held).
+     */
+    size_t reclaim_cancelled_locked();
+
+    /// Store the live item count in counters_data.depth (mutex_sync held)
+    void publish_depth_locked() {
+        counters_data.depth.store(current_size - tombstones, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Find the slot of the queued item with push sequence @p id (mutex_sync held).
+     */
+    size_t find_locked(uint64_t id) const;
+
+    /**
+     * @brief Remove the next item in queue_order and wake one producer (mutex_sync held).
+     */
+    T dequeue_locked();
+
+#ifdef SAFE_QUEUE_TRACING
+    /// Arrival time of a push, or 0 when tracing is disabled at runtime
+    static uint64_t trace_arrival() { return queue_trace::enabled() ? queue_trace::now_ns() : 0; }
+    void trace_push(uint64_t arrival_ns) const {
+        if (arrival_ns != 0) {
+            queue_trace::record(trace_id, trace_op::push, arrival_ns);
+        }
+    }
+    void trace_pop() const {
+        if (queue_trace::enabled()) {
+            queue_trace::record(trace_id, trace_op::pop, queue_trace::now_ns());
+        }
+    }
+#else
+    static uint64_t trace_arrival() { return 0; }
+    void trace_push(uint64_t) const {}
+    void trace_pop() const {}
+#endif
 
 public:
     /**
@@ -37,6 +300,23 @@ public:
      * @param max_capacity The maximum number of elements the queue can hold.
      */
     explicit safe_queue(size_t max_capacity);
+
+    /**
+     * @brief Construct a new safe queue object with the given buffer allocation.
+     * 
+     * @param max_capacity The maximum number of elements the queue can hold.
+     * @param storage queue_storage::lazy to commit the buffer as it is used.
+     */
+    safe_queue(size_t max_capacity, queue_storage storage);
+
+    /**
+     * @brief Construct a new safe queue object that pops in the given order.
+     * 
+     * @param max_capacity The maximum number of elements the queue can hold.
+     * @param pop_order Which queued item each pop serves.
+     * @param storage queue_storage::lazy to commit the buffer as it is used.
+     */
+    safe_queue(size_t max_capacity, queue_order pop_order, queue_storage storage = queue_storage::eager);
     
     /**
      * @brief Destroy the safe queue object.
@@ -48,7 +328,8 @@ public:
     /**
      * @brief Get the current number of elements in the queue.
      * 
-     * @return size_t The number of elements currently in the queue.
+     * @return size_t The number of elements currently in the queue, not
+     *         counting cancelled ones.
      */
     size_t size() const;
 
@@ -65,17 +346,125 @@ public:
      * 
      * @return true If the queue has reached maximum capacity.
      * @return false If the queue can accept more elements.
+     * 
+     * @note Counts slots held by cancelled items not yet reclaimed, since
+     *       pushes wait for those too.
      */
     bool full() const;
 
+    /**
+     * @brief Get the number of slots currently constructed.
+     * 
+     * @return size_t The maximum capacity for eager storage; for lazy storage
+     *         the slots committed so far.
+     */
+    size_t committed_capacity() const;
+
+    /**
+     * @brief Release the slots a lazy ring no longer needs.
+     * 
+     * Shrinks the ring to the smallest power-of-two multiple of its initial
+     * size that holds the current items and returns the freed pages to the
+     * kernel. No effect with eager storage.
+     */
+    void shrink_to_fit();
+
+    /**
+     * @brief Check if the queue has been closed.
+     * 
+     * @return true If close() has been called.
+     * @return false If the queue accepts pushes.
+     */
+    bool closed() const;
+
+    /**
+     * @brief Close the queue.
+     * 
+     * Later pushes fail with queue_status::closed, and blocked producers and
+     * consumers are woken. Consumers can still pop the items already queued;
+     * once it is empty, pops fail with queue_status::closed instead of blocking.
+     * Closing an already closed queue has no effect.
+     */
+    void close();
+
     /**
      * @brief Push an item into the queue (blocking).
      * 
      * @param item The item to push into the queue.
+     * @throws std::runtime_error If the queue is closed (the item is dropped in
+     *         SAFE_QUEUE_NO_EXCEPTIONS builds).
+     * 
+     * @return queue_handle Refers to the pushed item, for cancel(); empty if
+     *         the item was dropped.
      * 
      * @note This method will block if the queue is full until space becomes available.
      */
-    void push(const T& item);
+    queue_handle push(const T& item);
+
+    /**
+     * @brief Push an item into the queue, blocking until it is pushed or the queue is closed.
+     * 
+     * @param item The item to push into the queue.
+     * @return queue_status::ok If the item was pushed.
+     * @return queue_status::closed If the queue was closed before space became available.
+     */
+    queue_status wait_push(const T& item);
+
+    /**
+     * @brief Push an item, blocking until it is pushed or the queue is closed, and return its handle.
+     * 
+     * @param item The item to push into the queue.
+     * @param handle Receives the handle of the pushed item, for cancel().
+     * @return queue_status::ok If the item was pushed.
+     * @return queue_status::closed If the queue was closed before space became available.
+     */
+    queue_status wait_push(const T& item, queue_handle& handle);
+
+    /**
+     * @brief Cancel a queued item so no pop returns it.
+     * 
+     * @param handle The handle returned when the item was pushed.
+     * @return bool true if the item was still queued and is now cancelled;
+     *         false if it was already popped or cancelled.
+     */
+    bool cancel(const queue_handle& handle);
+
+    /**
+     * @brief Push an item at the head, so it is the next one a FIFO pop serves.
+     * 
+     * Meant for a consumer putting back an item it failed to process, so the
+     * retry does not wait behind the backlog. Blocks while the queue is full
+     * like wait_push(); a consumer re-inserting into a full queue therefore
+     * waits for another consumer to make room.
+     * 
+     * @param item The item to push.
+     * @return queue_status::ok If the item was pushed.
+     * @return queue_status::closed If the queue was closed before space became available.
+     */
+    queue_status push_front(const T& item);
+
+    /**
+     * @brief Push an item at the head, like push_front(const T&), and return its handle.
+     * 
+     * @param item The item to push.
+     * @param handle Receives the handle of the pushed item, for cancel().
+     * @return queue_status::ok If the item was pushed.
+     * @return queue_status::closed If the queue was closed before space became available.
+     */
+    queue_status push_front(const T& item, queue_handle& handle);
+
+    /**
+     * @brief Push several items in order, taking mutex_sync once per run of free slots.
+     * 
+     * Blocks while the queue is full, like push(). Consumers are woken once
+     * per stored run rather than once per item.
+     * 
+     * @param items The items to push.
+     * @param count The number of items.
+     * @return size_t The number of items pushed; less than @p count only if
+     *         the queue was closed.
+     */
+    size_t push_batch(const T* items, size_t count);
 
     /**
      * @brief Push an item into the queue with timeout.
@@ -83,32 +472,122 @@ public:
      * @param item The item to push into the queue.
      * @param timeout Maximum time to wait for space to become available.
      * @return true If the item was successfully pushed.
-     * @throws std::runtime_error If the timeout expires before space becomes available.
+     * @return false If the timeout expired or the queue is closed (SAFE_QUEUE_NO_EXCEPTIONS builds only).
+     * @throws std::runtime_error If the timeout expires before space becomes available
+     *         or the queue is closed.
      */
     bool push(const T& item, const std::chrono::milliseconds& timeout);
 
+    /**
+     * @brief Push an item into the queue with timeout, without throwing.
+     * 
+     * @param item The item to push into the queue.
+     * @param timeout Maximum time to wait for space to become available.
+     * @return queue_status::ok If the item was pushed.
+     * @return queue_status::timeout If the timeout expired before space became available.
+     * @return queue_status::closed If the queue is closed.
+     */
+    queue_status try_push(const T& item, const std::chrono::milliseconds& timeout);
+
     /**
      * @brief Pop an item from the queue (blocking).
      * 
      * @return T The popped item.
+     * @throws std::runtime_error If the queue is closed and empty (a
+     *         default-constructed T is returned in SAFE_QUEUE_NO_EXCEPTIONS builds).
      * 
      * @note This method will block if the queue is empty until an item becomes available.
      */
     T pop();
 
+    /**
+     * @brief Pop an item from the queue, blocking until one is available or the queue is closed and empty.
+     * 
+     * @param item Reference to store the popped item.
+     * @return queue_status::ok If an item was popped into @p item.
+     * @return queue_status::closed If the queue is closed and has been drained.
+     */
+    queue_status wait_pop(T& item);
+
+    /**
+     * @brief Pop the newest item, blocking until one is available or the queue is closed and empty.
+     * 
+     * Serves the tail regardless of the queue_order.
+     * 
+     * @param item Reference to store the popped item.
+     * @return queue_status::ok If an item was popped into @p item.
+     * @return queue_status::closed If the queue is closed and has been drained.
+     */
+    queue_status pop_back(T& item);
+
     /**
      * @brief Pop an item from the queue with timeout.
      * 
      * @param item Reference to store the popped item.
      * @param timeout Maximum time to wait for an item to become available.
      * @return true If an item was successfully popped.
-     * @throws std::runtime_error If the timeout expires before an item becomes available.
+     * @return false If the timeout expired or the queue is closed and empty
+     *         (SAFE_QUEUE_NO_EXCEPTIONS builds only).
+     * @throws std::runtime_error If the timeout expires before an item becomes available
+     *         or the queue is closed and empty.
      */
     bool pop(T& item, const std::chrono::milliseconds& timeout);
 
+    /**
+     * @brief Pop an item from the queue with timeout, without throwing.
+     * 
+     * @param item Reference to store the popped item.
+     * @param timeout Maximum time to wait for an item to become available.
+     * @return queue_status::ok If an item was popped into @p item.
+     * @return queue_status::timeout If the timeout expired before an item became available.
+     * @return queue_status::closed If the queue is closed and has been drained.
+     */
+    queue_status try_pop(T& item, const std::chrono::milliseconds& timeout);
+
+    /**
+     * @brief Pop up to @p max_items items under one acquisition of mutex_sync.
+     * 
+     * Returns at once with every available item (up to @p max_items) if the
+     * queue is not empty; otherwise waits at most @p max_wait for the first
+     * item and then takes whatever has accumulated by the time it wakes.
+     * Producers are woken once for the whole batch. With @p max_items zero
+     * nothing is taken and the call does not wait; it reports closed for a
+     * closed, drained queue and ok otherwise.
+     * 
+     * @param out Receives the items, appended in the order successive pops
+     *        would return them (see queue_order).
+     * @param max_items The maximum number of items to take.
+     * @param max_wait How long to wait for the first item.
+     * @return queue_status::ok If at least one item was appended to @p out
+     *         (or @p max_items is zero and the queue is open or not drained).
+     * @return queue_status::timeout If no item arrived within @p max_wait.
+     * @return queue_status::closed If the queue is closed and has been drained.
+     */
+    queue_status pop_batch(std::vector<T>& out, size_t max_items, const std::chrono::milliseconds& max_wait);
+
+    /**
+     * @brief Get the activity counters of the queue.
+     * 
+     * @return const queue_counters& Live counters, safe to read from any thread
+     *         without locking; used by queue_watchdog and queue_registry.
+     */
+    const queue_counters& counters() const { return counters_data; }
+
+#ifdef SAFE_QUEUE_LOCK_PROFILING
+    /**
+     * @brief Get the mutex acquire-wait and hold-time histograms.
+     * 
+     * @return const lock_profile& Live histograms, safe to read concurrently.
+     */
+    const lock_profile& lock_stats() const { return lock_data; }
+#endif
+
     // Disable copy and assignment
     safe_queue(const safe_queue&) = delete;            ///< Copy constructor is deleted
     safe_queue& operator=(const safe_queue&) = delete; ///< Assignment operator is deleted
 };
 
+// Template definitions
+#include "enqueue.cpp"
+
 #endif
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "fiber.h"
+
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <utility>
+
+/**
+ * @brief A fiber: entry function, stack and saved context.
+ */
+struct fiber {
+    enum class state { runnable, yielded, suspended, finished };
+
+    fiber_scheduler* owner = nullptr;
+    std::function<void()> entry;
+    ucontext_t context;                             ///< Saved registers while switched out
+    ucontext_t* worker_context = nullptr;           ///< Worker to return to, set on every switch in
+    void* stack = nullptr;                          ///< Mapping including the guard page
+    size_t stack_bytes = 0;
+    state status = state::runnable;
+    std::unique_lock<std::mutex>* pending_unlock = nullptr; ///< Released by the worker after suspension
+};
+
+namespace {
+
+thread_local fiber* running_fiber = nullptr;
+
+/// Kept out of line so the TLS address is never cached across a context switch.
+__attribute__((noinline)) fiber* load_running_fiber() {
+    return running_fiber;
+}
+
+__attribute__((noinline)) void store_running_fiber(fiber* f) {
+    running_fiber = f;
+}
+
+/// Save the fiber's context and return to the worker it runs on.
+void switch_to_worker(fiber* self) {
+    swapcontext(&self->context, self->worker_context);
+}
+
+void fiber_main() {
+    fiber* self = load_running_fiber();
+    self->entry();
+    self->entry = nullptr;
+    self->status = fiber::state::finished;
+    switch_to_worker(self);
+}
+
+} // namespace
+
+fiber_scheduler::fiber_scheduler(size_t worker_threads, size_t stack_size) : stack_size(stack_size) {
+    if (worker_threads == 0) {
+        worker_threads = 1;
+    }
+    for (size_t i = 0; i < worker_threads; ++i) {
+        workers.emplace_back(&fiber_scheduler::worker_loop, this);
+    }
+}
+
+fiber_scheduler::~fiber_scheduler() {
+    join();
+}
+
+void fiber_scheduler::spawn(std::function<void()> entry) {
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const size_t usable = (stack_size + page - 1) / page * page;
+
+    fiber* f = new fiber;
+    f->owner = this;
+    f->entry = std::move(entry);
+    f->stack_bytes = usable + page;
+    f->stack = ::mmap(nullptr, f->stack_bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (f->stack == MAP_FAILED) {
+        std::abort();
+    }
+    // The lowest page stays inaccessible so an overflow faults instead of corrupting memory.
+    ::mprotect(f->stack, page, PROT_NONE);
+
+    getcontext(&f->context);
+    f->context.uc_stack.ss_sp = static_cast<char*>(f->stack) + page;
+    f->context.uc_stack.ss_size = usable;
+    f->context.uc_link = nullptr;
+    makecontext(&f->context, fiber_main, 0);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ++live;
+    run_queue.push_back(f);
+    runnable.notify_one();
+}
+
+void fiber_scheduler::join() {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopping = true;
+        runnable.notify_all();
+    }
+    for (std::thread& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void fiber_scheduler::resume(fiber* f) {
+    f->owner->make_runnable(f);
+}
+
+void fiber_scheduler::make_runnable(fiber* f) {
+    std::lock_guard<std::mutex> lock(mutex);
+    f->status = fiber::state::runnable;
+    run_queue.push_back(f);
+    runnable.notify_one();
+}
+
+fiber* fiber_scheduler::next_runnable() {
+    std::unique_lock<std::mutex> lock(mutex);
+    runnable.wait(lock, [this]() { return !run_queue.empty() || (stopping && live == 0); });
+    if (run_queue.empty()) {
+        return nullptr;
+    }
+    fiber* f = run_queue.front();
+    run_queue.pop_front();
+    return f;
+}
+
+void fiber_scheduler::worker_loop() {
+    ucontext_t worker_context;
+    while (fiber* f = next_runnable()) {
+        f->worker_context = &worker_context;
+        store_running_fiber(f);
+        swapcontext(&worker_context, &f->context);
+        store_running_fiber(nullptr);
+
+        switch (f->status) {
+        case fiber::state::finished: {
+            ::munmap(f->stack, f->stack_bytes);
+            delete f;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--live == 0 && stopping) {
+                runnable.notify_all();
+            }
+            break;
+        }
+        case fiber::state::yielded:
+            make_runnable(f);
+            break;
+        case fiber::state::suspended: {
+            // From here another thread may resume f; nothing below touches it.
+            // Disown before unlocking, as the resumed fiber reuses the lock object.
+            std::mutex* held = f->pending_unlock->release();
+            f->pending_unlock = nullptr;
+            held->unlock();
+            break;
+        }
+        case fiber::state::runnable:
+            break;
+        }
+    }
+}
+
+namespace this_fiber {
+
+fiber* current() {
+    return load_running_fiber();
+}
+
+void yield() {
+    fiber* self = load_running_fiber();
+    if (self == nullptr) {
+        std::this_thread::yield();
+        return;
+    }
+    self->status = fiber::state::yielded;
+    switch_to_worker(self);
+}
+
+void suspend(std::unique_lock<std::mutex>& lock) {
+    fiber* self = load_running_fiber();
+    self->status = fiber::state::suspended;
+    std::mutex& held = *lock.mutex();
+    self->pending_unlock = &lock;
+    switch_to_worker(self);
+    // The worker disowned the lock to release it; take it again through a fresh owner.
+    lock = std::unique_lock<std::mutex>(held);
+}
+
+} // namespace this_fiber
@@ -0,0 +1,106 @@
+#ifndef FIBER_H
+#define FIBER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct fiber;
+
+/**
+ * @brief M:N runtime running many fibers on a few worker threads.
+ *
+ * A fiber is a function with its own small stack. Workers take runnable
+ * fibers from a shared run queue and switch to them with ucontext; when a
+ * fiber blocks (see this_fiber::suspend and safe_queue) it is parked and the
+ * worker switches to the next runnable fiber instead of blocking the thread.
+ * Thousands of logical actors can therefore wait on queues while only the
+ * worker threads exist in the kernel.
+ *
+ * Fibers may resume on a different worker than the one they blocked on, so
+ * fiber code must not hold on to thread_local state across a suspension.
+ * A fiber's entry function must not let an exception escape.
+ */
+class fiber_scheduler {
+public:
+    /**
+     * @brief Start @p worker_threads workers; they idle until fibers are spawned.
+     *
+     * @param worker_threads Number of OS threads running fibers (at least 1).
+     * @param stack_size Stack bytes for each fiber, plus one guard page.
+     */
+    explicit fiber_scheduler(size_t worker_threads, size_t stack_size = 64 * 1024);
+
+    /**
+     * @brief Wait for every fiber to finish and stop the workers.
+     */
+    ~fiber_scheduler();
+
+    fiber_scheduler(const fiber_scheduler&) = delete;
+    fiber_scheduler& operator=(const fiber_scheduler&) = delete;
+
+    /**
+     * @brief Create a fiber running @p entry; callable from any thread or fiber.
+     */
+    void spawn(std::function<void()> entry);
+
+    /**
+     * @brief Block until every fiber, including ones spawned meanwhile, has finished.
+     *
+     * Must be called from a plain thread, not from a fiber. The workers exit
+     * afterwards; no fiber can be spawned once join() has returned.
+     */
+    void join();
+
+    /**
+     * @brief Make a suspended fiber runnable again.
+     */
+    static void resume(fiber* f);
+
+private:
+    void worker_loop();
+    fiber* next_runnable();
+    void make_runnable(fiber* f);
+
+    const size_t stack_size;
+    std::mutex mutex;                       ///< Guards run_queue, live and stopping
+    std::condition_variable runnable;       ///< Signalled when run_queue grows or work ends
+    std::deque<fiber*> run_queue;
+    size_t live = 0;                        ///< Spawned fibers not yet finished
+    bool stopping = false;                  ///< join() called
+    std::vector<std::thread> workers;
+};
+
+/**
+ * @brief Operations on the calling fiber.
+ */
+namespace this_fiber {
+
+/**
+ * @brief Get the calling fiber, or nullptr on a plain thread.
+ */
+fiber* current();
+
+/**
+ * @brief Let other runnable fibers run before continuing. No-op on a plain thread.
+ */
+void yield();
+
+/**
+ * @brief Park the calling fiber until fiber_scheduler::resume() is called for it.
+ *
+ * @p lock is released only once the fiber has been switched out, so another
+ * thread that takes the same mutex and calls resume() can never resume the
+ * fiber before it is fully parked. The lock is re-acquired before returning.
+ *
+ * @pre Called on a fiber with @p lock held.
+ */
+void suspend(std::unique_lock<std::mutex>& lock);
+
+} // namespace this_fiber
+
+#endif
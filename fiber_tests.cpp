@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "fiber.h"
+#include "enqueue.h"
+
+TEST(FiberTest, RunsEveryFiberToCompletion) {
+    std::atomic<int> done(0);
+    {
+        fiber_scheduler scheduler(2);
+        for (int i = 0; i < 100; ++i) {
+            scheduler.spawn([&done]() {
+                this_fiber::yield();
+                ++done;
+            });
+        }
+        scheduler.join();
+    }
+    EXPECT_EQ(done, 100);
+    EXPECT_EQ(this_fiber::current(), nullptr);
+}
+
+TEST(FiberTest, ThousandsOfBlockedActorsOnOneWorker) {
+    // Every actor blocks on its own queue; a single worker must still make progress.
+    const int actors = 2000;
+    std::vector<std::unique_ptr<safe_queue<int>>> inboxes;
+    for (int i = 0; i < actors; ++i) {
+        inboxes.push_back(std::make_unique<safe_queue<int>>(1));
+    }
+    safe_queue<int> results(actors);
+    fiber_scheduler scheduler(1);
+    for (int i = 0; i < actors; ++i) {
+        scheduler.spawn([&inboxes, &results, i]() {
+            int value;
+            ASSERT_EQ(inboxes[i]->wait_pop(value), queue_status::ok);
+            results.wait_push(value * 2);
+        });
+    }
+    // Fed from a plain thread while the actors are parked.
+    for (int i = 0; i < actors; ++i) {
+        inboxes[i]->push(i);
+    }
+    long sum = 0;
+    int value;
+    for (int i = 0; i < actors; ++i) {
+        ASSERT_EQ(results.wait_pop(value), queue_status::ok);
+        sum += value;
+    }
+    scheduler.join();
+    EXPECT_EQ(sum, static_cast<long>(actors) * (actors - 1));
+}
+
+TEST(FiberTest, PipelineAcrossWorkersWithClose) {
+    safe_queue<int> stage(4);
+    std::atomic<long> sum(0);
+    fiber_scheduler scheduler(3);
+    for (int p = 0; p < 4; ++p) {
+        scheduler.spawn([&stage]() {
+            for (int i = 1; i <= 1000; ++i) {
+                stage.wait_push(i);
+            }
+        });
+    }
+    for (int c = 0; c < 4; ++c) {
+        scheduler.spawn([&stage, &sum]() {
+            int value;
+            while (stage.wait_pop(value) == queue_status::ok) {
+                sum += value;
+            }
+        });
+    }
+    // Close once everything has been consumed.
+    while (sum.load() != 4L * 1000 * 1001 / 2) {
+        std::this_thread::yield();
+    }
+    stage.close();
+    scheduler.join();
+    EXPECT_EQ(sum, 4L * 1000 * 1001 / 2);
+}
+
+TEST(FiberTest, SafeQueuePopParksFibers) {
+    // All consumers share one worker, so they can only block together if
+    // safe_queue::pop parks them instead of blocking the thread.
+    const int consumers = 50;
+    safe_queue<int> queue(4);
+    std::atomic<long> sum(0);
+    fiber_scheduler scheduler(1);
+    for (int c = 0; c < consumers; ++c) {
+        scheduler.spawn([&queue, &sum]() {
+            sum += queue.pop();
+        });
+    }
+    while (queue.counters().waiting_consumers.load() != static_cast<uint32_t>(consumers)) {
+        std::this_thread::yield();
+    }
+    for (int i = 1; i <= consumers; ++i) {
+        queue.push(i);
+    }
+    scheduler.join();
+    EXPECT_EQ(sum, static_cast<long>(consumers) * (consumers + 1) / 2);
+    EXPECT_EQ(queue.counters().waiting_consumers.load(), 0u);
+}
@@ -0,0 +1,109 @@
+#ifndef LOCK_PROFILE_H
+#define LOCK_PROFILE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @brief Lock-free power-of-two histogram of durations in nanoseconds.
+ *
+ * Bucket i counts durations in [2^(i-1), 2^i) ns (bucket 0 holds zero).
+ * Recording is a handful of relaxed atomic increments, so the histogram can
+ * be updated from the data path and read concurrently.
+ */
+class duration_histogram {
+public:
+    static constexpr size_t bucket_count = 48;  ///< Covers up to ~39 hours
+
+    /**
+     * @brief Record one duration.
+     */
+    void record(uint64_t ns) {
+        size_t bucket = ns == 0 ? 0 : 64 - static_cast<size_t>(__builtin_clzll(ns));
+        if (bucket >= bucket_count) {
+            bucket = bucket_count - 1;
+        }
+        buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        samples.fetch_add(1, std::memory_order_relaxed);
+        total_ns.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t seen = max_ns.load(std::memory_order_relaxed);
+        while (ns > seen && !max_ns.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t count() const { return samples.load(std::memory_order_relaxed); }   ///< Recorded durations
+    uint64_t total() const { return total_ns.load(std::memory_order_relaxed); }  ///< Sum in ns
+    uint64_t max() const { return max_ns.load(std::memory_order_relaxed); }      ///< Longest in ns
+
+    /**
+     * @brief Get the mean duration in nanoseconds, 0 if empty.
+     */
+    double mean() const {
+        uint64_t n = count();
+        return n == 0 ? 0.0 : static_cast<double>(total()) / static_cast<double>(n);
+    }
+
+    /**
+     * @brief Get an upper bound of the duration at quantile @p q (0.0 - 1.0).
+     *
+     * @return uint64_t The exclusive upper bound of the bucket holding the quantile.
+     */
+    uint64_t percentile(double q) const {
+        uint64_t n = count();
+        if (n == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(n - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucket_count; ++i) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                return i == 0 ? 0 : (uint64_t(1) << i);
+            }
+        }
+        return max();
+    }
+
+    /**
+     * @brief Get the number of durations in bucket @p i.
+     */
+    uint64_t bucket(size_t i) const { return buckets[i].load(std::memory_order_relaxed); }
+
+private:
+    std::array<std::atomic<uint64_t>, bucket_count> buckets{};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> total_ns{0};
+    std::atomic<uint64_t> max_ns{0};
+};
+
+/**
+ * @brief Mutex contention profile of one queue.
+ *
+ * acquire_wait is the time from requesting mutex_sync until owning it; hold is
+ * the time spent owning it, split at condition-variable waits (which release
+ * the mutex). Time blocked on a full or empty queue is in neither.
+ */
+struct lock_profile {
+    duration_histogram acquire_wait;    ///< Time spent waiting to acquire the mutex
+    duration_histogram hold;            ///< Time spent holding the mutex
+};
+
+/**
+ * @brief Write a one-line-per-histogram summary of a lock profile.
+ */
+inline void print_lock_profile(std::ostream& out, const lock_profile& profile) {
+    auto line = [&out](const char* name, const duration_histogram& h) {
+        out << name << ": n=" << h.count()
+            << " mean=" << h.mean() << "ns"
+            << " p50<" << h.percentile(0.50) << "ns"
+            << " p99<" << h.percentile(0.99) << "ns"
+            << " max=" << h.max() << "ns"
+            << " total=" << h.total() << "ns\n";
+    };
+    line("lock acquire wait", profile.acquire_wait);
+    line("lock hold", profile.hold);
+}
+
+#endif
@@ -1,74 +1,202 @@
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <string>
 #include <thread>
-#include <chrono>
-#include "enqueue.h"
-
-int main() {
-    // Create a safe_queue of integers with capacity 5
-    safe_queue<int> myQueue(5);
-
-    // Test basic operations
-    std::cout << "Queue empty? " << (myQueue.empty() ? "Yes" : "No") << std::endl;
-    std::cout << "Queue size: " << myQueue.size() << std::endl;
-
-    // Push some items
-    std::cout << "\nPushing items..." << std::endl;
-    for (int i = 1; i <= 5; ++i) {
-        myQueue.push(i);
-        std::cout << "Pushed: " << i << ", Size: " << myQueue.size() << std::endl;
+#include <vector>
+#include "bench.h"
+#include "bench_compare.h"
+#include "queue_trace.h"
+
+namespace {
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --queue NAME        queue variant: safe_queue, thread_safe_queue, safe_queue_lifo,\n"
+              << "                      safe_queue_hybrid (default safe_queue)\n"
+              << "  --producers N       producer threads (default 1)\n"
+              << "  --consumers N       consumer threads (default 1)\n"
+              << "  --capacity N        queue capacity in items (default 1024)\n"
+              << "  --payload BYTES     payload bytes copied with each item (default 0)\n"
+              << "  --rate N            target total items/s, 0 = unthrottled (default 0)\n"
+              << "  --duration MS       load duration in milliseconds (default 1000)\n"
+              << "  --pin               pin each thread to its own CPU\n"
+              << "  --no-counters       skip hardware performance counters\n"
+              << "  --sweep             sweep producers x consumers from 1 to --max-threads for\n"
+              << "                      every variant (or only --queue), pinned, as CSV by default\n"
+              << "  --max-threads N     largest thread count of a sweep (default: online CPUs)\n"
+              << "  --repetitions N     run every scenario N times (default 1)\n"
+              << "  --format FORMAT     json or csv (default json, csv for --sweep)\n"
+              << "  --output FILE       write results to FILE instead of stdout\n"
+              << "  --save FILE         also save results as a JSON baseline to FILE\n"
+              << "  --record-trace FILE record a push/pop trace for enqueue_replay to FILE\n"
+              << "                      (requires a build with ENQUEUE_TRACING)\n"
+              << "\n"
+              << "       " << program << " --compare BASELINE.json CANDIDATE.json\n"
+              << "  report significant throughput/latency deltas between two saved runs;\n"
+              << "  exits with status 3 if any significant regression is found\n";
+}
+
+bool parse_size(const char* text, size_t& value) {
+    char* end = nullptr;
+    unsigned long long parsed = std::strtoull(text, &end, 10);
+    if (end == text || *end != '\0') {
+        return false;
     }
+    value = static_cast<size_t>(parsed);
+    return true;
+}
+
+bool parse_double(const char* text, double& value) {
+    char* end = nullptr;
+    value = std::strtod(text, &end);
+    return end != text && *end == '\0';
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bench_config config;
+    std::string format;
+    std::string output;
+    bool sweep = false;
+    bool variant_given = false;
+    size_t max_threads = std::thread::hardware_concurrency();
+    size_t repetitions = 1;
+    std::string save;
+    std::string trace;
+
+    if (argc == 4 && std::string(argv[1]) == "--compare") {
+        std::vector<bench_result> baseline;
+        std::vector<bench_result> candidate;
+        std::string error;
+        if (!load_results(argv[2], baseline, error) || !load_results(argv[3], candidate, error)) {
+            std::cerr << error << "\n";
+            return 1;
+        }
+        return compare_results(baseline, candidate, std::cout) > 0 ? 3 : 0;
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        bool ok = true;
+        size_t number = 0;
+
+        if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg == "--pin") {
+            config.pin = true;
+            continue;
+        } else if (arg == "--no-counters") {
+            config.counters = false;
+            continue;
+        } else if (arg == "--sweep") {
+            sweep = true;
+            continue;
+        } else if (value == nullptr) {
+            ok = false;
+        } else if (arg == "--queue") {
+            ok = parse_variant(value, config.variant);
+            variant_given = true;
+        } else if (arg == "--producers") {
+            ok = parse_size(value, config.producers) && config.producers > 0;
+        } else if (arg == "--consumers") {
+            ok = parse_size(value, config.consumers) && config.consumers > 0;
+        } else if (arg == "--capacity") {
+            ok = parse_size(value, config.capacity) && config.capacity > 0;
+        } else if (arg == "--payload") {
+            ok = parse_size(value, config.payload_size);
+        } else if (arg == "--rate") {
+            ok = parse_double(value, config.rate) && config.rate >= 0.0;
+        } else if (arg == "--duration") {
+            ok = parse_size(value, number);
+            config.duration = std::chrono::milliseconds(number);
+        } else if (arg == "--max-threads") {
+            ok = parse_size(value, max_threads) && max_threads > 0;
+        } else if (arg == "--repetitions") {
+            ok = parse_size(value, repetitions) && repetitions > 0;
+        } else if (arg == "--save") {
+            save = value;
+        } else if (arg == "--record-trace") {
+            trace = value;
+        } else if (arg == "--format") {
+            format = value;
+            ok = format == "json" || format == "csv";
+        } else if (arg == "--output") {
+            output = value;
+        } else {
+            ok = false;
+        }
 
-    // Check if full
-    std::cout << "\nQueue full? " << (myQueue.full() ? "Yes" : "No") << std::endl;
+        if (!ok) {
+            std::cerr << "Invalid or incomplete option: " << arg << "\n";
+            print_usage(argv[0]);
+            return 2;
+        }
+        ++i;
+    }
 
-    // Try pushing with timeout (should throw)
-    try {
-        std::cout << "\nTrying to push with timeout (should fail)..." << std::endl;
-        myQueue.push(6, std::chrono::milliseconds(100));
-    } catch (const std::runtime_error& e) {
-        std::cout << "Error: " << e.what() << std::endl;
+    if (format.empty()) {
+        format = sweep ? "csv" : "json";
+    }
+    if (max_threads == 0) {
+        max_threads = 1;
     }
 
-    // Pop items
-    std::cout << "\nPopping items..." << std::endl;
-    while (!myQueue.empty()) {
-        int val = myQueue.pop();
-        std::cout << "Popped: " << val << ", Size: " << myQueue.size() << std::endl;
+    if (!trace.empty()) {
+#ifndef SAFE_QUEUE_TRACING
+        std::cerr << "Warning: built without ENQUEUE_TRACING, the trace will be empty\n";
+#endif
+        queue_trace::set_enabled(true);
     }
 
-    // Try popping with timeout (should throw)
-    try {
-        std::cout << "\nTrying to pop with timeout (should fail)..." << std::endl;
-        int val;
-        myQueue.pop(val, std::chrono::milliseconds(100));
-    } catch (const std::runtime_error& e) {
-        std::cout << "Error: " << e.what() << std::endl;
+    std::vector<bench_result> results;
+    for (size_t repetition = 0; repetition < repetitions; ++repetition) {
+        if (sweep) {
+            std::vector<queue_variant> variants = all_variants();
+            if (variant_given) {
+                variants.assign(1, config.variant);
+            }
+            std::vector<bench_result> swept = run_sweep(config, variants, max_threads, &std::cerr);
+            results.insert(results.end(), swept.begin(), swept.end());
+        } else {
+            results.push_back(run_bench(config));
+        }
     }
 
-    // Demonstrate multi-threaded usage
-    std::cout << "\nStarting producer-consumer demo..." << std::endl;
-    
-    // Producer thread
-    std::thread producer([&myQueue]() {
-        for (int i = 10; i < 15; ++i) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(200));
-            myQueue.push(i);
-            std::cout << "Produced: " << i << std::endl;
+    if (!trace.empty()) {
+        queue_trace::set_enabled(false);
+        if (!queue_trace::write(trace)) {
+            std::cerr << "Cannot write trace " << trace << "\n";
+            return 1;
         }
-    });
-
-    // Consumer thread
-    std::thread consumer([&myQueue]() {
-        for (int i = 0; i < 5; ++i) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(300));
-            int val = myQueue.pop();
-            std::cout << "Consumed: " << val << std::endl;
+    }
+
+    if (!save.empty()) {
+        std::ofstream baseline(save);
+        if (!baseline) {
+            std::cerr << "Cannot open " << save << " for writing\n";
+            return 1;
         }
-    });
+        write_json(baseline, results);
+    }
 
-    producer.join();
-    consumer.join();
+    std::ofstream file;
+    if (!output.empty()) {
+        file.open(output);
+        if (!file) {
+            std::cerr << "Cannot open " << output << " for writing\n";
+            return 1;
+        }
+    }
+    std::ostream& out = output.empty() ? std::cout : file;
 
-    std::cout << "\nDemo complete!" << std::endl;
+    if (format == "csv") {
+        write_csv(out, results);
+    } else {
+        write_json(out, results);
+    }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,104 @@
+#include "memory_budget.h"
+
+#include <algorithm>
+
+memory_budget::memory_budget(size_t total_bytes) : total_bytes(total_bytes) {}
+
+memory_budget::account::account(memory_budget& budget, size_t reserve_bytes) : budget(budget) {
+    std::lock_guard<std::mutex> lock(budget.mutex);
+    const size_t unreserved = budget.total_bytes - budget.reserved_bytes.load(std::memory_order_relaxed);
+    // Reserved bytes still lent to other accounts stay borrowed until returned.
+    const size_t lendable = unreserved - std::min(unreserved, budget.borrowed_bytes.load(std::memory_order_relaxed));
+    reserve = std::min(reserve_bytes, lendable);
+    budget.reserved_bytes.store(budget.reserved_bytes.load(std::memory_order_relaxed) + reserve,
+                                std::memory_order_relaxed);
+}
+
+memory_budget::account::~account() {
+    release(used());
+    std::lock_guard<std::mutex> lock(budget.mutex);
+    budget.reserved_bytes.store(budget.reserved_bytes.load(std::memory_order_relaxed) - reserve,
+                                std::memory_order_relaxed);
+    if (budget.waiters > 0) {
+        budget.released.notify_all();
+    }
+}
+
+bool memory_budget::account::acquire(size_t bytes) {
+    std::unique_lock<std::mutex> lock(budget.mutex);
+    if (budget.extra_borrow(*this, bytes) == SIZE_MAX) {
+        return false;
+    }
+    if (!budget.fits(*this, bytes)) {
+        ++budget.waiters;
+        budget.released.wait(lock, [this, bytes]() { return budget.fits(*this, bytes); });
+        --budget.waiters;
+    }
+    budget.take(*this, bytes);
+    return true;
+}
+
+bool memory_budget::account::acquire_for(size_t bytes, std::chrono::nanoseconds timeout) {
+    std::unique_lock<std::mutex> lock(budget.mutex);
+    if (budget.extra_borrow(*this, bytes) == SIZE_MAX) {
+        return false;
+    }
+    if (!budget.fits(*this, bytes)) {
+        ++budget.waiters;
+        const bool satisfied = budget.released.wait_for(lock, timeout,
+                                                        [this, bytes]() { return budget.fits(*this, bytes); });
+        --budget.waiters;
+        if (!satisfied) {
+            return false;
+        }
+    }
+    budget.take(*this, bytes);
+    return true;
+}
+
+bool memory_budget::account::try_acquire(size_t bytes) {
+    std::lock_guard<std::mutex> lock(budget.mutex);
+    if (!budget.fits(*this, bytes)) {
+        return false;
+    }
+    budget.take(*this, bytes);
+    return true;
+}
+
+void memory_budget::account::release(size_t bytes) {
+    if (bytes == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(budget.mutex);
+    const size_t held = used_bytes.load(std::memory_order_relaxed);
+    const size_t returned_borrow = borrowed(held) - borrowed(held - bytes);
+    used_bytes.store(held - bytes, std::memory_order_relaxed);
+    budget.used_bytes.store(budget.used_bytes.load(std::memory_order_relaxed) - bytes,
+                            std::memory_order_relaxed);
+    budget.borrowed_bytes.store(budget.borrowed_bytes.load(std::memory_order_relaxed) - returned_borrow,
+                                std::memory_order_relaxed);
+    if (budget.waiters > 0) {
+        budget.released.notify_all();
+    }
+}
+
+size_t memory_budget::extra_borrow(const account& acct, size_t bytes) const {
+    const size_t held = acct.used_bytes.load(std::memory_order_relaxed);
+    const size_t pool = total_bytes - reserved_bytes.load(std::memory_order_relaxed);
+    const size_t extra = acct.borrowed(held + bytes) - acct.borrowed(held);
+    return acct.borrowed(held + bytes) > pool ? SIZE_MAX : extra;
+}
+
+bool memory_budget::fits(const account& acct, size_t bytes) const {
+    const size_t extra = extra_borrow(acct, bytes);
+    const size_t pool = total_bytes - reserved_bytes.load(std::memory_order_relaxed);
+    return extra != SIZE_MAX && borrowed_bytes.load(std::memory_order_relaxed) + extra <= pool;
+}
+
+void memory_budget::take(account& acct, size_t bytes) {
+    const size_t held = acct.used_bytes.load(std::memory_order_relaxed);
+    const size_t extra = acct.borrowed(held + bytes) - acct.borrowed(held);
+    acct.used_bytes.store(held + bytes, std::memory_order_relaxed);
+    used_bytes.store(used_bytes.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+    borrowed_bytes.store(borrowed_bytes.load(std::memory_order_relaxed) + extra, std::memory_order_relaxed);
+}
@@ -0,0 +1,138 @@
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+/**
+ * @brief Byte budget shared by many queues.
+ *
+ * Every queue draws from the budget through its own account. An account is
+ * guaranteed its reservation: it can always hold up to reserved() bytes,
+ * whatever the other accounts do. The part of the total not reserved by any
+ * account forms a shared pool that accounts borrow from, first come first
+ * served, when they exceed their reservation. Acquisitions that do not fit
+ * block (acquire, acquire_for) or fail (try_acquire), which is the
+ * backpressure the queues pass on to their producers.
+ *
+ * The aggregate memory is bounded by the total, while a burst on one queue
+ * can use the idle share of the others and a busy queue can never starve a
+ * quiet one below its reservation.
+ *
+ * The budget must outlive its accounts. Usage figures are readable lock-free.
+ */
+class memory_budget {
+public:
+    /**
+     * @brief One queue's share of a memory_budget.
+     *
+     * Registers with the budget on construction and returns its reservation
+     * and any bytes still held on destruction.
+     */
+    class account {
+    public:
+        /**
+         * @brief Open an account reserving @p reserve_bytes of @p budget.
+         *
+         * The reservation is clamped to what other accounts have not already
+         * reserved; check reserved() for the granted amount.
+         */
+        account(memory_budget& budget, size_t reserve_bytes);
+
+        ~account();
+
+        account(const account&) = delete;
+        account& operator=(const account&) = delete;
+
+        /**
+         * @brief Take @p bytes, blocking until they fit.
+         *
+         * @return bool false if the request can never fit (larger than the
+         *         reservation plus the whole shared pool).
+         */
+        bool acquire(size_t bytes);
+
+        /**
+         * @brief Take @p bytes, waiting at most @p timeout for them to fit.
+         *
+         * @return bool false on timeout or if the request can never fit.
+         */
+        bool acquire_for(size_t bytes, std::chrono::nanoseconds timeout);
+
+        /**
+         * @brief Take @p bytes only if they fit right now.
+         */
+        bool try_acquire(size_t bytes);
+
+        /**
+         * @brief Return @p bytes previously acquired and wake waiting accounts.
+         */
+        void release(size_t bytes);
+
+        /**
+         * @brief Get the bytes this account holds, without locking.
+         */
+        size_t used() const { return used_bytes.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Get the guaranteed bytes of this account.
+         */
+        size_t reserved() const { return reserve; }
+
+    private:
+        friend class memory_budget;
+
+        size_t borrowed(size_t used) const { return used > reserve ? used - reserve : 0; }
+
+        memory_budget& budget;
+        size_t reserve;                         ///< Guaranteed bytes
+        std::atomic<size_t> used_bytes{0};      ///< Held bytes (written under budget.mutex)
+    };
+
+    /**
+     * @brief Construct a budget of @p total_bytes.
+     */
+    explicit memory_budget(size_t total_bytes);
+
+    memory_budget(const memory_budget&) = delete;
+    memory_budget& operator=(const memory_budget&) = delete;
+
+    /**
+     * @brief Get the total bytes of the budget.
+     */
+    size_t total() const { return total_bytes; }
+
+    /**
+     * @brief Get the bytes held by all accounts, without locking.
+     */
+    size_t used() const { return used_bytes.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the bytes reserved by the open accounts, without locking.
+     */
+    size_t reserved() const { return reserved_bytes.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the bytes borrowed from the shared pool, without locking.
+     */
+    size_t borrowed() const { return borrowed_bytes.load(std::memory_order_relaxed); }
+
+private:
+    /// Bytes @p acct would borrow for @p bytes more, or SIZE_MAX if it can never fit
+    size_t extra_borrow(const account& acct, size_t bytes) const;
+    bool fits(const account& acct, size_t bytes) const;
+    void take(account& acct, size_t bytes);
+
+    const size_t total_bytes;
+    std::mutex mutex;                           ///< Guards all usage figures
+    std::condition_variable released;           ///< Signalled when bytes are returned
+    size_t waiters = 0;                         ///< Threads blocked in acquire
+    std::atomic<size_t> used_bytes{0};
+    std::atomic<size_t> reserved_bytes{0};
+    std::atomic<size_t> borrowed_bytes{0};
+};
+
+#endif
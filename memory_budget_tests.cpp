@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "byte_queue.h"
+#include "memory_budget.h"
+
+TEST(MemoryBudgetTest, ReservationIsGuaranteed) {
+    memory_budget budget(100);
+    memory_budget::account busy(budget, 20);
+    memory_budget::account quiet(budget, 30);
+    EXPECT_EQ(budget.reserved(), 50u);
+
+    // busy may use its reservation plus the whole shared pool of 50...
+    EXPECT_TRUE(busy.try_acquire(70));
+    EXPECT_FALSE(busy.try_acquire(1));
+    EXPECT_EQ(budget.borrowed(), 50u);
+    // ...but never the reservation of quiet.
+    EXPECT_TRUE(quiet.try_acquire(30));
+    EXPECT_FALSE(quiet.try_acquire(1));
+    EXPECT_EQ(budget.used(), 100u);
+
+    busy.release(70);
+    EXPECT_EQ(budget.borrowed(), 0u);
+    EXPECT_TRUE(quiet.try_acquire(50));
+    EXPECT_EQ(quiet.used(), 80u);
+}
+
+TEST(MemoryBudgetTest, ReservationsAreClampedToTheTotal) {
+    memory_budget budget(100);
+    memory_budget::account a(budget, 80);
+    memory_budget::account b(budget, 80);
+    EXPECT_EQ(a.reserved(), 80u);
+    EXPECT_EQ(b.reserved(), 20u);
+    EXPECT_FALSE(a.acquire(81));  // can never fit, fails instead of blocking
+}
+
+TEST(MemoryBudgetTest, ClosingAccountReturnsItsBytes) {
+    memory_budget budget(100);
+    {
+        memory_budget::account a(budget, 10);
+        EXPECT_TRUE(a.try_acquire(60));
+        EXPECT_EQ(budget.used(), 60u);
+    }
+    EXPECT_EQ(budget.used(), 0u);
+    EXPECT_EQ(budget.reserved(), 0u);
+    EXPECT_EQ(budget.borrowed(), 0u);
+}
+
+TEST(MemoryBudgetTest, AcquireBlocksUntilRelease) {
+    memory_budget budget(10);
+    memory_budget::account a(budget, 0);
+    memory_budget::account b(budget, 0);
+    ASSERT_TRUE(a.try_acquire(10));
+    EXPECT_FALSE(b.acquire_for(5, std::chrono::milliseconds(10)));
+
+    std::thread waiter([&b] { EXPECT_TRUE(b.acquire(5)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    a.release(5);
+    waiter.join();
+    EXPECT_EQ(b.used(), 5u);
+}
+
+TEST(MemoryBudgetTest, QueuesShareTheBudget) {
+    auto weigh = [](const std::string& s) { return s.size(); };
+    memory_budget budget(12);
+    memory_budget::account first_account(budget, 4);
+    memory_budget::account second_account(budget, 4);
+    byte_queue<std::string> first(100, weigh, first_account);
+    byte_queue<std::string> second(100, weigh, second_account);
+
+    // first fills its reservation and the shared pool.
+    EXPECT_EQ(first.offer(std::string(8, 'a')), queue_status::ok);
+    EXPECT_EQ(first.offer("b"), queue_status::timeout);
+    EXPECT_EQ(first.try_push("b", std::chrono::milliseconds(10)), queue_status::timeout);
+    // second still gets its guaranteed share.
+    EXPECT_EQ(second.offer(std::string(4, 'c')), queue_status::ok);
+    EXPECT_EQ(budget.used(), 12u);
+
+    std::string item;
+    EXPECT_EQ(first.pop(item), queue_status::ok);
+    EXPECT_EQ(budget.used(), 4u);
+    // The freed pool now lets second grow past its reservation.
+    EXPECT_EQ(second.push(std::string(4, 'd')), queue_status::ok);
+    EXPECT_EQ(second_account.used(), 8u);
+    EXPECT_EQ(first.offer("e"), queue_status::ok);
+    EXPECT_EQ(budget.used(), 9u);
+}
@@ -0,0 +1,148 @@
+#include "parking_lot.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace parking_lot {
+
+namespace {
+
+/**
+ * @brief A parked thread; lives on the parking thread's stack.
+ */
+struct waiter {
+    const void* address = nullptr;
+    waiter* next = nullptr;
+    bool unparked = false;              ///< Set under the bucket lock by unpark
+    std::condition_variable wake;
+};
+
+/**
+ * @brief FIFO of waiters whose addresses hash here.
+ */
+struct alignas(64) bucket {
+    std::mutex mutex;
+    waiter* head = nullptr;
+    waiter* tail = nullptr;
+
+    void append(waiter* w) {
+        if (tail == nullptr) {
+            head = w;
+        } else {
+            tail->next = w;
+        }
+        tail = w;
+    }
+
+    /// Unlink @p w, whose predecessor is @p prev (nullptr at the head)
+    void unlink(waiter* prev, waiter* w) {
+        if (prev == nullptr) {
+            head = w->next;
+        } else {
+            prev->next = w->next;
+        }
+        if (tail == w) {
+            tail = prev;
+        }
+        w->next = nullptr;
+    }
+};
+
+constexpr size_t bucket_bits = 10;
+bucket buckets[size_t(1) << bucket_bits];
+
+bucket& bucket_for(const void* address) {
+    // Fibonacci hashing spreads nearby addresses of adjacent objects.
+    const uint64_t key = reinterpret_cast<uintptr_t>(address) * 0x9E3779B97F4A7C15ull;
+    return buckets[key >> (64 - bucket_bits)];
+}
+
+} // namespace
+
+namespace detail {
+
+bool park(const void* address, validate_fn validate, void* context, const clock::time_point* deadline) {
+    bucket& b = bucket_for(address);
+    std::unique_lock<std::mutex> lock(b.mutex);
+    if (!validate(context)) {
+        return false;
+    }
+
+    waiter self;
+    self.address = address;
+    b.append(&self);
+    if (deadline == nullptr) {
+        self.wake.wait(lock, [&self]() { return self.unparked; });
+        return true;
+    }
+    if (self.wake.wait_until(lock, *deadline, [&self]() { return self.unparked; })) {
+        return true;
+    }
+
+    // Timed out: leave the queue unless an unpark raced in and already did it.
+    waiter* prev = nullptr;
+    for (waiter* w = b.head; w != nullptr; prev = w, w = w->next) {
+        if (w == &self) {
+            b.unlink(prev, w);
+            break;
+        }
+    }
+    return false;
+}
+
+bool unpark_one(const void* address, unparked_fn on_unpark, void* context) {
+    bucket& b = bucket_for(address);
+    std::lock_guard<std::mutex> lock(b.mutex);
+    waiter* found = nullptr;
+    waiter* prev = nullptr;
+    for (waiter* w = b.head; w != nullptr; prev = w, w = w->next) {
+        if (w->address == address) {
+            found = w;
+            b.unlink(prev, w);
+            break;
+        }
+    }
+
+    // Waiters after the found one are the only candidates left.
+    bool have_more = false;
+    waiter* rest = found == nullptr ? nullptr : (prev == nullptr ? b.head : prev->next);
+    for (waiter* w = rest; w != nullptr; w = w->next) {
+        if (w->address == address) {
+            have_more = true;
+            break;
+        }
+    }
+    on_unpark(context, have_more);
+
+    if (found != nullptr) {
+        found->unparked = true;
+        found->wake.notify_one();
+    }
+    return found != nullptr;
+}
+
+} // namespace detail
+
+size_t unpark_all(const void* address) {
+    bucket& b = bucket_for(address);
+    std::lock_guard<std::mutex> lock(b.mutex);
+    size_t woken = 0;
+    waiter* prev = nullptr;
+    waiter* w = b.head;
+    while (w != nullptr) {
+        waiter* next = w->next;
+        if (w->address == address) {
+            b.unlink(prev, w);
+            w->unparked = true;
+            w->wake.notify_one();
+            ++woken;
+        } else {
+            prev = w;
+        }
+        w = next;
+    }
+    return woken;
+}
+
+} // namespace parking_lot
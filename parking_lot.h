@@ -0,0 +1,81 @@
+#ifndef PARKING_LOT_H
+#define PARKING_LOT_H
+
+#include <chrono>
+#include <cstddef>
+
+/**
+ * @brief Process-wide table of threads blocked on arbitrary addresses.
+ *
+ * Instead of embedding a mutex and condition variables in every object, an
+ * object keeps a few state bits in an atomic word and parks waiting threads
+ * here, keyed by an address it owns. Waiters live in a fixed set of hashed
+ * buckets, so the sync state an object carries is independent of how many
+ * threads may block on it.
+ *
+ * park() re-checks a caller-supplied condition under the bucket lock before
+ * sleeping, and unpark_one() runs a callback under the same lock, so an
+ * object can clear its "someone is parked" bit exactly when the last waiter
+ * leaves without missing wake-ups.
+ */
+namespace parking_lot {
+
+using clock = std::chrono::steady_clock;
+
+namespace detail {
+using validate_fn = bool (*)(void* context);
+using unparked_fn = void (*)(void* context, bool have_more);
+
+bool park(const void* address, validate_fn validate, void* context, const clock::time_point* deadline);
+bool unpark_one(const void* address, unparked_fn on_unpark, void* context);
+} // namespace detail
+
+/**
+ * @brief Block the calling thread on @p address until unparked.
+ *
+ * @param validate Called under the bucket lock; the thread parks only if it
+ *        returns true, so a state change made before the matching unpark is
+ *        never missed.
+ * @return bool true if woken by an unpark, false if @p validate failed.
+ */
+template <typename Validate>
+bool park(const void* address, Validate validate) {
+    return detail::park(address, [](void* v) { return (*static_cast<Validate*>(v))(); }, &validate, nullptr);
+}
+
+/**
+ * @brief Like park(), but give up at @p deadline.
+ *
+ * @return bool true if woken by an unpark, false if @p validate failed or
+ *         the deadline passed.
+ */
+template <typename Validate>
+bool park_until(const void* address, Validate validate, clock::time_point deadline) {
+    return detail::park(address, [](void* v) { return (*static_cast<Validate*>(v))(); }, &validate, &deadline);
+}
+
+/**
+ * @brief Wake the longest-parked thread on @p address.
+ *
+ * @param on_unpark Called as on_unpark(have_more) under the bucket lock,
+ *        even if no thread was parked; have_more tells whether threads remain
+ *        parked on @p address.
+ * @return bool true if a thread was woken.
+ */
+template <typename Callback>
+bool unpark_one(const void* address, Callback on_unpark) {
+    return detail::unpark_one(address,
+                              [](void* c, bool have_more) { (*static_cast<Callback*>(c))(have_more); },
+                              &on_unpark);
+}
+
+/**
+ * @brief Wake every thread parked on @p address.
+ *
+ * @return size_t The number of threads woken.
+ */
+size_t unpark_all(const void* address);
+
+} // namespace parking_lot
+
+#endif
@@ -0,0 +1,127 @@
+#include "perf_counters.h"
+
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+/**
+ * @brief Open one disabled counting event for this process and the threads it creates.
+ *
+ * Kernel-mode counting is tried first; with a restrictive perf_event_paranoid
+ * the event is retried in user mode only.
+ */
+int open_event(uint32_t type, uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.inherit = 1;
+    attr.disabled = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    if (fd < 0) {
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+    return fd;
+}
+
+} // namespace
+
+perf_counters::perf_counters() {
+    fds[cycles] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fds[instructions] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    fds[llc_misses] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    fds[branch_misses] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    fds[context_switches] = open_event(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+}
+
+perf_counters::~perf_counters() {
+    for (int fd : fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+void perf_counters::start() {
+    for (int fd : fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+void perf_counters::stop() {
+    for (int fd : fds) {
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+}
+
+perf_counters::sample perf_counters::read() const {
+    sample result;
+    for (size_t i = 0; i < counter_count; ++i) {
+        if (fds[i] < 0) {
+            continue;
+        }
+        // value, time enabled, time running
+        uint64_t data[3] = {0, 0, 0};
+        if (::read(fds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) {
+            continue;
+        }
+        uint64_t value = data[0];
+        if (data[2] != 0 && data[2] < data[1]) {
+            // The PMU was multiplexed; extrapolate to the full enabled time
+            value = static_cast<uint64_t>(static_cast<double>(value) * data[1] / data[2]);
+        }
+        result.available[i] = true;
+        result.values[i] = value;
+    }
+    return result;
+}
+
+bool perf_counters::any_available() const {
+    for (int fd : fds) {
+        if (fd >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* perf_counters::name(counter which) {
+    switch (which) {
+    case cycles:
+        return "cycles";
+    case instructions:
+        return "instructions";
+    case llc_misses:
+        return "llc_misses";
+    case branch_misses:
+        return "branch_misses";
+    case context_switches:
+        return "context_switches";
+    default:
+        return "unknown";
+    }
+}
+
+perf_counters::sample perf_counters::sample::operator-(const sample& earlier) const {
+    sample delta;
+    for (size_t i = 0; i < counter_count; ++i) {
+        delta.available[i] = available[i] && earlier.available[i];
+        delta.values[i] = delta.available[i] ? values[i] - earlier.values[i] : 0;
+    }
+    return delta;
+}
@@ -0,0 +1,88 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @brief Hardware and software event counters read via perf_event_open.
+ *
+ * Counters are opened for the calling process with inheritance, so threads
+ * created after construction are counted as well. They start disabled and
+ * count only between start() and stop(), which reach the inherited copies in
+ * every thread too, so thread creation and set-up before start() are not
+ * included. Any counter the kernel refuses (missing PMU,
+ * perf_event_paranoid, containers) is simply marked unavailable; the others
+ * keep working.
+ */
+class perf_counters {
+public:
+    /**
+     * @brief Events collected by perf_counters.
+     */
+    enum counter {
+        cycles,             ///< CPU cycles
+        instructions,       ///< Retired instructions
+        llc_misses,         ///< Last-level cache misses
+        branch_misses,      ///< Mispredicted branches
+        context_switches,   ///< Context switches
+        counter_count
+    };
+
+    /**
+     * @brief Counter values captured at one point in time, or a difference of two.
+     */
+    struct sample {
+        std::array<bool, counter_count> available{};    ///< Whether each counter could be read
+        std::array<uint64_t, counter_count> values{};   ///< Counter values, scaled for multiplexing
+
+        /**
+         * @brief Get the per-counter difference from an earlier sample.
+         */
+        sample operator-(const sample& earlier) const;
+    };
+
+    /**
+     * @brief Open all counters, disabled, for the calling process and its future threads.
+     */
+    perf_counters();
+
+    /**
+     * @brief Close all counters.
+     */
+    ~perf_counters();
+
+    /**
+     * @brief Zero every counter and start counting, in all threads.
+     */
+    void start();
+
+    /**
+     * @brief Stop counting, in all threads; read() keeps returning the totals.
+     */
+    void stop();
+
+    /**
+     * @brief Read the current value of every available counter.
+     */
+    sample read() const;
+
+    /**
+     * @brief Check whether at least one counter could be opened.
+     */
+    bool any_available() const;
+
+    /**
+     * @brief Get the short name of a counter (e.g. "llc_misses").
+     */
+    static const char* name(counter which);
+
+    // Disable copy and assignment
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+private:
+    std::array<int, counter_count> fds;
+};
+
+#endif
@@ -1,7 +1,9 @@
 #include <chrono>
 #include <condition_variable>
 #include <mutex>
+#ifndef SAFE_QUEUE_NO_EXCEPTIONS
 #include <stdexcept>
+#endif
 
 template <typename T>
 class safe_queue {
@@ -62,7 +64,11 @@ public:
         std::unique_lock<std::mutex> lock(mutex_sync);
         
         if (!is_full.wait_for(lock, timeout, [this]() { return enqueue_element < maximum_capacity; })) {
+#ifdef SAFE_QUEUE_NO_EXCEPTIONS
+            return false;
+#else
             throw std::runtime_error("Push timeout - queue is full");
+#endif
         }
         
         queue_size[last] = item;
@@ -91,7 +97,11 @@ public:
         std::unique_lock<std::mutex> lock(mutex_sync);
         
         if (!is_empty.wait_for(lock, timeout, [this]() { return enqueue_element > 0; })) {
+#ifdef SAFE_QUEUE_NO_EXCEPTIONS
+            return false;
+#else
             throw std::runtime_error("Pop timeout - queue is empty");
+#endif
         }
         
         item = queue_size[first];
@@ -5,7 +5,9 @@
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
+#ifndef SAFE_QUEUE_NO_EXCEPTIONS
 #include <stdexcept>
+#endif
 #include <memory>  // For std::unique_ptr in C++11/14 or later
 
 template <typename T>
@@ -86,7 +88,11 @@ bool ThreadSafeQueue<T>::push(const T& item, const std::chrono::milliseconds& ti
     std::unique_lock<std::mutex> lock(mtx);
     
     if (!not_full.wait_for(lock, timeout, [this]() { return count < capacity; })) {
+#ifdef SAFE_QUEUE_NO_EXCEPTIONS
+        return false;
+#else
         throw std::runtime_error("Push timeout - queue is full");
+#endif
     }
     
     buffer[rear] = item;
@@ -115,7 +121,11 @@ bool ThreadSafeQueue<T>::pop(T& item, const std::chrono::milliseconds& timeout)
     std::unique_lock<std::mutex> lock(mtx);
     
     if (!not_empty.wait_for(lock, timeout, [this]() { return count > 0; })) {
+#ifdef SAFE_QUEUE_NO_EXCEPTIONS
+        return false;
+#else
         throw std::runtime_error("Pop timeout - queue is empty");
+#endif
     }
     
     item = buffer[front];
@@ -0,0 +1,121 @@
+#ifndef QUEUE_CLOCK_H
+#define QUEUE_CLOCK_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+/**
+ * @brief Default clock policy for the timed queue operations.
+ *
+ * A clock policy provides the time_point type, now(), and a wait_until() that
+ * blocks on a condition variable until a predicate holds or a deadline passes.
+ * This one uses std::chrono::steady_clock and real waits.
+ */
+struct steady_clock_policy {
+    using time_point = std::chrono::steady_clock::time_point;   ///< Point in time of this clock
+
+    /**
+     * @brief Get the current time.
+     */
+    static time_point now() {
+        return std::chrono::steady_clock::now();
+    }
+
+    /**
+     * @brief Wait until @p ready returns true or @p deadline passes.
+     *
+     * @return bool The final value of @p ready.
+     */
+    template <typename Predicate>
+    static bool wait_until(std::condition_variable& cv,
+                           std::unique_lock<std::mutex>& lock,
+                           time_point deadline,
+                           Predicate ready) {
+        return cv.wait_until(lock, deadline, ready);
+    }
+};
+
+/**
+ * @brief Virtual-time clock policy for deterministic, fast timeout tests.
+ *
+ * Time is a process-wide counter that only moves when advanced. In the
+ * default auto-advance mode a waiter whose predicate is false moves the
+ * virtual time straight to its deadline and times out without sleeping, so
+ * timeout paths run instantly and always observe exactly their timeout.
+ *
+ * With auto-advance disabled, waiters stay blocked until another thread makes
+ * the predicate true or calls advance() past their deadline.
+ */
+class virtual_clock {
+public:
+    using duration = std::chrono::nanoseconds;                      ///< Tick of the virtual clock
+    using time_point = std::chrono::time_point<virtual_clock, duration>; ///< Point in virtual time
+
+    /**
+     * @brief Get the current virtual time.
+     */
+    static time_point now() {
+        return time_point(duration(current.load(std::memory_order_acquire)));
+    }
+
+    /**
+     * @brief Move the virtual time forward by @p step.
+     */
+    static void advance(duration step) {
+        current.fetch_add(step.count(), std::memory_order_acq_rel);
+    }
+
+    /**
+     * @brief Select whether waiters jump the time to their deadline (the default).
+     */
+    static void set_auto_advance(bool enabled) {
+        auto_advance.store(enabled, std::memory_order_release);
+    }
+
+    /**
+     * @brief Reset the virtual time to zero and re-enable auto-advance.
+     */
+    static void reset() {
+        current.store(0, std::memory_order_release);
+        auto_advance.store(true, std::memory_order_release);
+    }
+
+    /**
+     * @brief Wait until @p ready returns true or the virtual @p deadline passes.
+     *
+     * @return bool The final value of @p ready.
+     */
+    template <typename Predicate>
+    static bool wait_until(std::condition_variable& cv,
+                           std::unique_lock<std::mutex>& lock,
+                           time_point deadline,
+                           Predicate ready) {
+        while (!ready()) {
+            if (auto_advance.load(std::memory_order_acquire)) {
+                // Nothing can happen in virtual time while we wait, so the
+                // deadline is reached immediately
+                int64_t target = deadline.time_since_epoch().count();
+                int64_t seen = current.load(std::memory_order_acquire);
+                while (seen < target && !current.compare_exchange_weak(seen, target)) {
+                }
+                return ready();
+            }
+            if (now() >= deadline) {
+                return ready();
+            }
+            // advance() cannot signal the queue's condition variables, so
+            // manual mode re-checks the virtual time at a short real interval
+            cv.wait_for(lock, std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+private:
+    static inline std::atomic<int64_t> current{0};
+    static inline std::atomic<bool> auto_advance{true};
+};
+
+#endif
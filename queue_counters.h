@@ -0,0 +1,65 @@
+#ifndef QUEUE_COUNTERS_H
+#define QUEUE_COUNTERS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Activity counters of one queue, readable without taking its lock.
+ *
+ * The queue updates these with relaxed atomic operations while it holds its
+ * own mutex, so monitoring threads (queue_watchdog, queue_registry) can sample
+ * them at any time without contending with the data path. Clock reads happen
+ * only when a thread is about to block.
+ */
+struct queue_counters {
+    std::atomic<uint64_t> pushes{0};                    ///< Items pushed so far
+    std::atomic<uint64_t> pops{0};                      ///< Items popped so far
+    std::atomic<uint64_t> timeouts{0};                  ///< Timed operations that expired
+    std::atomic<uint64_t> expired{0};                   ///< Items evicted unread because their time-to-live passed
+    std::atomic<uint64_t> cancelled{0};                 ///< Queued items cancelled through their handle
+    std::atomic<size_t> depth{0};                       ///< Items currently queued
+    std::atomic<size_t> capacity{0};                    ///< Maximum number of items
+    std::atomic<uint32_t> waiting_producers{0};         ///< Producers blocked on a full queue
+    std::atomic<uint32_t> waiting_consumers{0};         ///< Consumers blocked on an empty queue
+    std::atomic<int64_t> producers_blocked_since_ns{0}; ///< steady_clock ns since which producers have been blocked, 0 if none
+    std::atomic<int64_t> consumers_blocked_since_ns{0}; ///< steady_clock ns since which consumers have been blocked, 0 if none
+    std::atomic<size_t> bytes{0};                       ///< Total weight of queued items (byte-bounded queues)
+    std::atomic<size_t> byte_budget{0};                 ///< Maximum total weight, 0 if bounded by count only
+};
+
+/**
+ * @brief Increment a counter that only the lock holder writes.
+ *
+ * A plain load and store instead of a locked read-modify-write; concurrent
+ * readers still see whole values.
+ */
+template <typename Integer>
+inline void bump_counter(std::atomic<Integer>& counter, Integer delta = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Count a thread about to block; stamps @p since_ns if it is the first.
+ */
+inline void begin_counted_wait(std::atomic<uint32_t>& waiting, std::atomic<int64_t>& since_ns) {
+    if (waiting.load(std::memory_order_relaxed) == 0) {
+        since_ns.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count(), std::memory_order_relaxed);
+    }
+    bump_counter(waiting);
+}
+
+/**
+ * @brief Count a thread that stopped blocking; clears @p since_ns if it was the last.
+ */
+inline void end_counted_wait(std::atomic<uint32_t>& waiting, std::atomic<int64_t>& since_ns) {
+    bump_counter(waiting, static_cast<uint32_t>(-1));
+    if (waiting.load(std::memory_order_relaxed) == 0) {
+        since_ns.store(0, std::memory_order_relaxed);
+    }
+}
+
+#endif
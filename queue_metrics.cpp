@@ -0,0 +1,220 @@
+#include "queue_metrics.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <ostream>
+#include <sstream>
+
+namespace {
+
+int64_t steady_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Escape a label value: backslash, double quote and newline.
+ */
+std::string escape_label(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+double blocked_seconds(int64_t since_ns, int64_t now_ns) {
+    return since_ns == 0 || now_ns < since_ns ? 0.0 : static_cast<double>(now_ns - since_ns) / 1e9;
+}
+
+bool send_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+void render_prometheus(std::ostream& out, const std::vector<queue_sample>& samples, int64_t now_ns) {
+    std::vector<std::string> labels;
+    labels.reserve(samples.size());
+    for (const queue_sample& s : samples) {
+        labels.push_back("{queue=\"" + escape_label(s.name) + "\"}");
+    }
+
+    auto family = [&](const char* name, const char* type, const char* help, auto value) {
+        out << "# HELP " << name << " " << help << "\n"
+            << "# TYPE " << name << " " << type << "\n";
+        for (size_t i = 0; i < samples.size(); ++i) {
+            out << name << labels[i] << " " << value(samples[i]) << "\n";
+        }
+    };
+
+    family("safe_queue_depth", "gauge", "Items currently queued.",
+           [](const queue_sample& s) { return s.depth; });
+    family("safe_queue_capacity", "gauge", "Maximum number of items.",
+           [](const queue_sample& s) { return s.capacity; });
+    family("safe_queue_bytes", "gauge", "Total weight of queued items (byte-bounded queues).",
+           [](const queue_sample& s) { return s.bytes; });
+    family("safe_queue_byte_budget", "gauge", "Maximum total weight, 0 if bounded by item count.",
+           [](const queue_sample& s) { return s.byte_budget; });
+    family("safe_queue_pushes_total", "counter", "Items pushed.",
+           [](const queue_sample& s) { return s.pushes; });
+    family("safe_queue_pops_total", "counter", "Items popped.",
+           [](const queue_sample& s) { return s.pops; });
+    family("safe_queue_timeouts_total", "counter", "Timed push or pop operations that expired.",
+           [](const queue_sample& s) { return s.timeouts; });
+    family("safe_queue_expired_total", "counter", "Items evicted unread after their time-to-live.",
+           [](const queue_sample& s) { return s.expired; });
+    family("safe_queue_cancelled_total", "counter", "Queued items cancelled before being popped.",
+           [](const queue_sample& s) { return s.cancelled; });
+    family("safe_queue_waiting_producers", "gauge", "Producers blocked on a full queue.",
+           [](const queue_sample& s) { return s.waiting_producers; });
+    family("safe_queue_waiting_consumers", "gauge", "Consumers blocked on an empty queue.",
+           [](const queue_sample& s) { return s.waiting_consumers; });
+    family("safe_queue_producers_blocked_seconds", "gauge",
+           "How long producers have been continuously blocked.",
+           [now_ns](const queue_sample& s) { return blocked_seconds(s.producers_blocked_since_ns, now_ns); });
+    family("safe_queue_consumers_blocked_seconds", "gauge",
+           "How long consumers have been continuously blocked.",
+           [now_ns](const queue_sample& s) { return blocked_seconds(s.consumers_blocked_since_ns, now_ns); });
+}
+
+void render_prometheus(std::ostream& out, const queue_registry& registry) {
+    std::vector<queue_sample> samples = registry.collect();
+    render_prometheus(out, samples, steady_now_ns());
+}
+
+bool write_prometheus_file(const std::string& path, const queue_registry& registry) {
+    const std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        render_prometheus(file, registry);
+        file.flush();
+        if (!file) {
+            std::remove(temp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+metrics_server::metrics_server(const queue_registry& registry) : registry(registry) {}
+
+metrics_server::~metrics_server() {
+    stop();
+}
+
+bool metrics_server::start(uint16_t port) {
+    if (running.load()) {
+        return false;
+    }
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+    int reuse = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    socklen_t len = sizeof(addr);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(fd, 16) != 0 ||
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    listen_fd = fd;
+    bound_port = ntohs(addr.sin_port);
+    running.store(true);
+    worker = std::thread(&metrics_server::run, this);
+    return true;
+}
+
+void metrics_server::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    worker.join();
+    ::close(listen_fd);
+    listen_fd = -1;
+    bound_port = 0;
+}
+
+void metrics_server::run() {
+    pollfd pfd{listen_fd, POLLIN, 0};
+    while (running.load()) {
+        // Wake periodically so stop() is noticed without a self-connection.
+        if (::poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+        int client = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client >= 0) {
+            serve(client);
+            ::close(client);
+        }
+    }
+}
+
+void metrics_server::serve(int client) {
+    timeval timeout{1, 0};
+    ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    // Only the request line matters; read until it is complete.
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n") == std::string::npos && request.size() < 8192) {
+        ssize_t n = ::recv(client, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            return;
+        }
+        request.append(buffer, static_cast<size_t>(n));
+    }
+
+    std::string status;
+    std::string body;
+    if (request.compare(0, 13, "GET /metrics ") == 0) {
+        std::ostringstream text;
+        render_prometheus(text, registry);
+        status = "200 OK";
+        body = text.str();
+    } else {
+        status = "404 Not Found";
+        body = "Not found\n";
+    }
+    send_all(client, "HTTP/1.1 " + status + "\r\n"
+                     "Content-Type: text/plain; version=0.0.4\r\n"
+                     "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                     "Connection: close\r\n\r\n" + body);
+}
@@ -0,0 +1,93 @@
+#ifndef QUEUE_METRICS_H
+#define QUEUE_METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <thread>
+#include <vector>
+#include "queue_registry.h"
+
+/**
+ * @brief Write samples in the Prometheus text exposition format (0.0.4).
+ *
+ * Every queue becomes a series labelled queue="<name>" of the metrics
+ * safe_queue_depth, safe_queue_capacity, safe_queue_bytes,
+ * safe_queue_byte_budget, safe_queue_pushes_total,
+ * safe_queue_pops_total, safe_queue_timeouts_total, safe_queue_expired_total,
+ * safe_queue_cancelled_total,
+ * safe_queue_waiting_producers, safe_queue_waiting_consumers,
+ * safe_queue_producers_blocked_seconds and safe_queue_consumers_blocked_seconds.
+ * The blocked durations are measured up to @p now_ns (steady_clock ns).
+ */
+void render_prometheus(std::ostream& out, const std::vector<queue_sample>& samples, int64_t now_ns);
+
+/**
+ * @brief Write the current state of a registry in the Prometheus text format.
+ */
+void render_prometheus(std::ostream& out, const queue_registry& registry);
+
+/**
+ * @brief Write the metrics of a registry to a file, replacing it atomically.
+ *
+ * The text goes to "<path>.tmp" which is then renamed over @p path, so a
+ * reader such as the node_exporter textfile collector never sees a partial
+ * file.
+ *
+ * @return bool false if the file could not be written.
+ */
+bool write_prometheus_file(const std::string& path, const queue_registry& registry);
+
+/**
+ * @brief Minimal HTTP endpoint serving GET /metrics on the loopback interface.
+ *
+ * One background thread accepts connections on 127.0.0.1 and answers each
+ * with a fresh render_prometheus() of the registry. Requests are served one at
+ * a time; this is meant for a local scraper, not for general HTTP traffic.
+ */
+class metrics_server {
+public:
+    /**
+     * @brief Construct a server for @p registry; call start() to listen.
+     */
+    explicit metrics_server(const queue_registry& registry);
+
+    /**
+     * @brief Stop the server if it is running.
+     */
+    ~metrics_server();
+
+    metrics_server(const metrics_server&) = delete;
+    metrics_server& operator=(const metrics_server&) = delete;
+
+    /**
+     * @brief Listen on 127.0.0.1:@p port and start serving.
+     *
+     * @param port TCP port, or 0 to pick a free one (see port()).
+     * @return bool false if already running or the socket could not be bound.
+     */
+    bool start(uint16_t port);
+
+    /**
+     * @brief Stop serving and close the socket; no-op if not running.
+     */
+    void stop();
+
+    /**
+     * @brief Get the port being listened on, 0 if not running.
+     */
+    uint16_t port() const { return bound_port; }
+
+private:
+    void run();
+    void serve(int client);
+
+    const queue_registry& registry;
+    int listen_fd = -1;
+    uint16_t bound_port = 0;
+    std::atomic<bool> running{false};
+    std::thread worker;
+};
+
+#endif
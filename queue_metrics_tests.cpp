@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "enqueue.h"
+#include "queue_metrics.h"
+#include "queue_registry.h"
+
+namespace {
+
+std::string http_get(uint16_t port, const std::string& path) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    std::string response;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+        std::string request = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+        ::send(fd, request.data(), request.size(), 0);
+        char buffer[4096];
+        ssize_t n;
+        while ((n = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            response.append(buffer, static_cast<size_t>(n));
+        }
+    }
+    ::close(fd);
+    return response;
+}
+
+} // namespace
+
+TEST(QueueRegistryTest, AddRemoveAndCollect) {
+    queue_registry registry;
+    safe_queue<int> a(4);
+    safe_queue<int> b(8);
+    EXPECT_TRUE(registry.add("a", a));
+    EXPECT_TRUE(registry.add("b", b));
+    EXPECT_FALSE(registry.add("a", b));
+    EXPECT_EQ(registry.size(), 2u);
+
+    a.push(1);
+    a.push(2);
+    a.pop();
+    std::vector<queue_sample> samples = registry.collect();
+    ASSERT_EQ(samples.size(), 2u);
+    EXPECT_EQ(samples[0].name, "a");
+    EXPECT_EQ(samples[0].depth, 1u);
+    EXPECT_EQ(samples[0].capacity, 4u);
+    EXPECT_EQ(samples[0].pushes, 2u);
+    EXPECT_EQ(samples[0].pops, 1u);
+    EXPECT_EQ(samples[1].capacity, 8u);
+
+    EXPECT_TRUE(registry.remove("a"));
+    EXPECT_FALSE(registry.remove("a"));
+    EXPECT_EQ(registry.size(), 1u);
+}
+
+TEST(QueueMetricsTest, RendersPrometheusText) {
+    queue_sample sample{"in\"put", 3, 10, 7, 4, 1, 5, 6, 2, 0, 1000000000, 0, 300, 1000};
+    std::ostringstream out;
+    render_prometheus(out, {sample}, 3500000000);
+    const std::string text = out.str();
+    EXPECT_NE(text.find("# TYPE safe_queue_depth gauge\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE safe_queue_pushes_total counter\n"), std::string::npos);
+    EXPECT_NE(text.find("safe_queue_depth{queue=\"in\\\"put\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("safe_queue_pops_total{queue=\"in\\\"put\"} 4\n"), std::string::npos);
+    EXPECT_NE(text.find("safe_queue_expired_total{queue=\"in\\\"put\"} 5\n"), std::string::npos);
+    EXPECT_NE(text.find("safe_queue_cancelled_total{queue=\"in\\\"put\"} 6\n"), std::string::npos);
+    EXPECT_NE(text.find("safe_queue_byte_budget{queue=\"in\\\"put\"} 1000\n"), std::string::npos);
+    EXPECT_NE(text.find("safe_queue_waiting_producers{queue=\"in\\\"put\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("safe_queue_producers_blocked_seconds{queue=\"in\\\"put\"} 2.5\n"), std::string::npos);
+    EXPECT_NE(text.find("safe_queue_consumers_blocked_seconds{queue=\"in\\\"put\"} 0\n"), std::string::npos);
+}
+
+TEST(QueueMetricsTest, WritesFile) {
+    queue_registry registry;
+    safe_queue<int> q(2);
+    registry.add("file", q);
+    q.push(1);
+    const std::string path = "queue_metrics_test.prom";
+    ASSERT_TRUE(write_prometheus_file(path, registry));
+    std::ifstream file(path);
+    std::stringstream text;
+    text << file.rdbuf();
+    EXPECT_NE(text.str().find("safe_queue_depth{queue=\"file\"} 1\n"), std::string::npos);
+    std::remove(path.c_str());
+}
+
+TEST(QueueMetricsTest, ServesMetricsOverHttp) {
+    queue_registry registry;
+    safe_queue<int> q(2);
+    registry.add("http", q);
+    q.push(1);
+
+    metrics_server server(registry);
+    ASSERT_TRUE(server.start(0));
+    ASSERT_NE(server.port(), 0);
+
+    std::string response = http_get(server.port(), "/metrics");
+    EXPECT_EQ(response.compare(0, 15, "HTTP/1.1 200 OK"), 0);
+    EXPECT_NE(response.find("safe_queue_pushes_total{queue=\"http\"} 1\n"), std::string::npos);
+
+    response = http_get(server.port(), "/other");
+    EXPECT_EQ(response.compare(0, 12, "HTTP/1.1 404"), 0);
+    server.stop();
+    EXPECT_EQ(server.port(), 0);
+}
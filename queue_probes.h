@@ -0,0 +1,46 @@
+#ifndef QUEUE_PROBES_H
+#define QUEUE_PROBES_H
+
+/**
+ * @file queue_probes.h
+ * @brief USDT static tracepoints for the queue operations.
+ *
+ * With SAFE_QUEUE_USDT defined (CMake option ENQUEUE_USDT) and <sys/sdt.h>
+ * available, safe_queue exposes these probes under the "safe_queue" provider:
+ *
+ * | probe       | arguments                                      |
+ * |-------------|------------------------------------------------|
+ * | push        | queue id, depth after the push                 |
+ * | pop         | queue id, depth after the pop                  |
+ * | block_start | queue id, depth, side (0 producer, 1 consumer) |
+ * | block_end   | queue id, depth, side, wait duration in ns     |
+ * | timeout     | queue id, depth, side                          |
+ * | close       | queue id, depth at close                       |
+ *
+ * The queue id is the address of the queue object. An unattached probe is a
+ * single nop; the arguments of push and pop are values already in registers,
+ * and block_start/block_end/timeout fire only on the slow path where the
+ * thread is about to sleep or has just woken. Without SAFE_QUEUE_USDT or
+ * <sys/sdt.h>, the probes compile to nothing.
+ *
+ * Example: bpftrace -e 'usdt:./app:safe_queue:block_end { @wait = hist(arg3); }'
+ */
+
+#if defined(SAFE_QUEUE_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define SAFE_QUEUE_HAS_USDT 1
+#endif
+#endif
+
+#ifdef SAFE_QUEUE_HAS_USDT
+#define SAFE_QUEUE_PROBE2(name, a1, a2) DTRACE_PROBE2(safe_queue, name, a1, a2)
+#define SAFE_QUEUE_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(safe_queue, name, a1, a2, a3)
+#define SAFE_QUEUE_PROBE4(name, a1, a2, a3, a4) DTRACE_PROBE4(safe_queue, name, a1, a2, a3, a4)
+#else
+#define SAFE_QUEUE_PROBE2(name, a1, a2) ((void)0)
+#define SAFE_QUEUE_PROBE3(name, a1, a2, a3) ((void)0)
+#define SAFE_QUEUE_PROBE4(name, a1, a2, a3, a4) ((void)0)
+#endif
+
+#endif
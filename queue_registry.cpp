@@ -0,0 +1,60 @@
+#include "queue_registry.h"
+
+#include <algorithm>
+
+queue_registry& queue_registry::global() {
+    static queue_registry instance;
+    return instance;
+}
+
+bool queue_registry::add(const std::string& name, const queue_counters& counters) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const entry& e : entries) {
+        if (e.name == name) {
+            return false;
+        }
+    }
+    entries.push_back(entry{name, &counters});
+    return true;
+}
+
+bool queue_registry::remove(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = std::find_if(entries.begin(), entries.end(),
+                           [&name](const entry& e) { return e.name == name; });
+    if (it == entries.end()) {
+        return false;
+    }
+    entries.erase(it);
+    return true;
+}
+
+size_t queue_registry::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+std::vector<queue_sample> queue_registry::collect() const {
+    std::vector<queue_sample> samples;
+    std::lock_guard<std::mutex> lock(mutex);
+    samples.reserve(entries.size());
+    for (const entry& e : entries) {
+        const queue_counters& c = *e.counters;
+        samples.push_back(queue_sample{
+            e.name,
+            c.depth.load(std::memory_order_relaxed),
+            c.capacity.load(std::memory_order_relaxed),
+            c.pushes.load(std::memory_order_relaxed),
+            c.pops.load(std::memory_order_relaxed),
+            c.timeouts.load(std::memory_order_relaxed),
+            c.expired.load(std::memory_order_relaxed),
+            c.cancelled.load(std::memory_order_relaxed),
+            c.waiting_producers.load(std::memory_order_relaxed),
+            c.waiting_consumers.load(std::memory_order_relaxed),
+            c.producers_blocked_since_ns.load(std::memory_order_relaxed),
+            c.consumers_blocked_since_ns.load(std::memory_order_relaxed),
+            c.bytes.load(std::memory_order_relaxed),
+            c.byte_budget.load(std::memory_order_relaxed)});
+    }
+    return samples;
+}
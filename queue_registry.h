@@ -0,0 +1,90 @@
+#ifndef QUEUE_REGISTRY_H
+#define QUEUE_REGISTRY_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "queue_counters.h"
+
+/**
+ * @brief Point-in-time values of one registered queue's counters.
+ */
+struct queue_sample {
+    std::string name;                       ///< Name the queue was registered under
+    size_t depth;                           ///< Items queued
+    size_t capacity;                        ///< Maximum number of items
+    uint64_t pushes;                        ///< Items pushed so far
+    uint64_t pops;                          ///< Items popped so far
+    uint64_t timeouts;                      ///< Timed operations that expired
+    uint64_t expired;                       ///< Items evicted because their time-to-live passed
+    uint64_t cancelled;                     ///< Queued items cancelled through their handle
+    uint32_t waiting_producers;             ///< Producers blocked on a full queue
+    uint32_t waiting_consumers;             ///< Consumers blocked on an empty queue
+    int64_t producers_blocked_since_ns;     ///< steady_clock ns, 0 if no producer is blocked
+    int64_t consumers_blocked_since_ns;     ///< steady_clock ns, 0 if no consumer is blocked
+    size_t bytes;                           ///< Total weight of queued items
+    size_t byte_budget;                     ///< Maximum total weight, 0 if bounded by count only
+};
+
+/**
+ * @brief Named collection of queues for process-wide monitoring.
+ *
+ * The registry stores pointers to each queue's queue_counters and reads
+ * them with relaxed atomic loads, so collecting a sample never takes a queue
+ * mutex. Its own mutex guards only the list of names and is taken on
+ * registration and collection, never on the queue data path.
+ *
+ * Registered counters must outlive their registration; remove() a queue
+ * before destroying it.
+ */
+class queue_registry {
+public:
+    /**
+     * @brief Get the process-wide registry.
+     */
+    static queue_registry& global();
+
+    /**
+     * @brief Register counters under @p name.
+     *
+     * @return bool false if the name is already registered.
+     */
+    bool add(const std::string& name, const queue_counters& counters);
+
+    /**
+     * @brief Register any queue exposing counters(), such as safe_queue.
+     */
+    template <typename Queue>
+    bool add(const std::string& name, const Queue& queue) {
+        return add(name, queue.counters());
+    }
+
+    /**
+     * @brief Unregister the queue registered under @p name.
+     *
+     * @return bool false if no queue has that name.
+     */
+    bool remove(const std::string& name);
+
+    /**
+     * @brief Get the number of registered queues.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Sample every registered queue, in registration order.
+     */
+    std::vector<queue_sample> collect() const;
+
+private:
+    struct entry {
+        std::string name;
+        const queue_counters* counters;
+    };
+
+    mutable std::mutex mutex;   ///< Guards entries
+    std::vector<entry> entries;
+};
+
+#endif
@@ -0,0 +1,150 @@
+#include "queue_trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+namespace queue_trace {
+
+namespace detail {
+std::atomic<bool> enabled_flag(false);
+}
+
+namespace {
+
+constexpr size_t chunk_events = 4096;
+constexpr char trace_magic[8] = {'S', 'Q', 'T', 'R', 'A', 'C', 'E', '1'};
+
+/**
+ * @brief Fixed-size block of events; count is published with release order.
+ */
+struct trace_chunk {
+    std::atomic<size_t> count{0};
+    trace_event events[chunk_events];
+};
+
+/**
+ * @brief Events of one thread. Only the owning thread appends.
+ */
+struct thread_buffer {
+    uint16_t thread_id = 0;
+    std::mutex chunks_mutex;                            ///< Guards chunks against snapshot()
+    std::vector<std::unique_ptr<trace_chunk>> chunks;
+    trace_chunk* current = nullptr;
+};
+
+/**
+ * @brief All thread buffers; they outlive their threads so events survive thread exit.
+ */
+struct buffer_registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<thread_buffer>> buffers;
+};
+
+buffer_registry& registry() {
+    static buffer_registry instance;
+    return instance;
+}
+
+thread_local thread_buffer* local_buffer = nullptr;
+
+thread_buffer& this_thread_buffer() {
+    if (local_buffer == nullptr) {
+        buffer_registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.buffers.push_back(std::make_unique<thread_buffer>());
+        local_buffer = reg.buffers.back().get();
+        local_buffer->thread_id = static_cast<uint16_t>(reg.buffers.size() - 1);
+    }
+    return *local_buffer;
+}
+
+} // namespace
+
+void set_enabled(bool enabled) {
+    detail::enabled_flag.store(enabled, std::memory_order_relaxed);
+}
+
+void record(uint32_t queue_id, trace_op op, uint64_t timestamp_ns) {
+    thread_buffer& buffer = this_thread_buffer();
+    trace_chunk* chunk = buffer.current;
+    if (chunk == nullptr || chunk->count.load(std::memory_order_relaxed) == chunk_events) {
+        auto fresh = std::make_unique<trace_chunk>();
+        chunk = fresh.get();
+        std::lock_guard<std::mutex> lock(buffer.chunks_mutex);
+        buffer.chunks.push_back(std::move(fresh));
+        buffer.current = chunk;
+    }
+
+    size_t index = chunk->count.load(std::memory_order_relaxed);
+    trace_event& event = chunk->events[index];
+    event.timestamp_ns = timestamp_ns;
+    event.queue_id = queue_id;
+    event.thread_id = buffer.thread_id;
+    event.op = static_cast<uint8_t>(op);
+    event.reserved = 0;
+    chunk->count.store(index + 1, std::memory_order_release);
+}
+
+uint32_t next_queue_id() {
+    static std::atomic<uint32_t> next(0);
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<trace_event> snapshot() {
+    std::vector<trace_event> events;
+    buffer_registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto& buffer : reg.buffers) {
+        std::lock_guard<std::mutex> chunks_lock(buffer->chunks_mutex);
+        for (const auto& chunk : buffer->chunks) {
+            size_t count = chunk->count.load(std::memory_order_acquire);
+            events.insert(events.end(), chunk->events, chunk->events + count);
+        }
+    }
+    std::stable_sort(events.begin(), events.end(), [](const trace_event& a, const trace_event& b) {
+        return a.timestamp_ns < b.timestamp_ns;
+    });
+    return events;
+}
+
+void clear() {
+    buffer_registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto& buffer : reg.buffers) {
+        std::lock_guard<std::mutex> chunks_lock(buffer->chunks_mutex);
+        buffer->chunks.clear();
+        buffer->current = nullptr;
+    }
+}
+
+bool write(const std::string& path) {
+    std::vector<trace_event> events = snapshot();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+    uint64_t count = events.size();
+    file.write(trace_magic, sizeof(trace_magic));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(events.data()),
+               static_cast<std::streamsize>(events.size() * sizeof(trace_event)));
+    return static_cast<bool>(file);
+}
+
+bool read(const std::string& path, std::vector<trace_event>& events) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(trace_magic)];
+    uint64_t count = 0;
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, trace_magic, sizeof(magic)) != 0 ||
+        !file.read(reinterpret_cast<char*>(&count), sizeof(count))) {
+        return false;
+    }
+    events.resize(count);
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(events.data()),
+                                       static_cast<std::streamsize>(count * sizeof(trace_event))));
+}
+
+} // namespace queue_trace
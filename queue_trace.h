@@ -0,0 +1,115 @@
+#ifndef QUEUE_TRACE_H
+#define QUEUE_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Queue operation recorded in a trace.
+ */
+enum class trace_op : uint8_t {
+    push = 0,   ///< A producer called push (recorded on entry, i.e. at arrival)
+    pop = 1     ///< A consumer completed a pop
+};
+
+/**
+ * @brief One recorded queue event, 16 bytes in memory and on disk.
+ */
+struct trace_event {
+    uint64_t timestamp_ns;  ///< steady_clock time of the event in nanoseconds
+    uint32_t queue_id;      ///< Queue the event belongs to (see queue_trace::next_queue_id)
+    uint16_t thread_id;     ///< Recording thread, numbered in order of first event
+    uint8_t op;             ///< trace_op of the event
+    uint8_t reserved;       ///< Always zero
+};
+
+static_assert(sizeof(trace_event) == 16, "trace_event must stay compact");
+
+/**
+ * @brief Process-wide recorder of queue push/pop events.
+ *
+ * Queues built with SAFE_QUEUE_TRACING (CMake option ENQUEUE_TRACING) call
+ * record() while tracing is enabled. Each thread appends to its own buffer of
+ * fixed-size chunks, so recording never takes a lock shared with other
+ * threads. write() merges all buffers into a compact binary file that
+ * enqueue_replay can play back against any queue variant.
+ */
+namespace queue_trace {
+
+/**
+ * @brief Start or stop recording.
+ */
+void set_enabled(bool enabled);
+
+/**
+ * @brief Check whether recording is enabled.
+ */
+inline bool enabled();
+
+/**
+ * @brief Get the current steady_clock time in nanoseconds, as used in events.
+ */
+inline uint64_t now_ns();
+
+/**
+ * @brief Record an event for the calling thread.
+ *
+ * @param queue_id The queue the event belongs to.
+ * @param op The operation.
+ * @param timestamp_ns When the operation happened, from now_ns().
+ */
+void record(uint32_t queue_id, trace_op op, uint64_t timestamp_ns);
+
+/**
+ * @brief Allocate a process-unique queue id for tagging events.
+ */
+uint32_t next_queue_id();
+
+/**
+ * @brief Get all events recorded so far, ordered by timestamp.
+ */
+std::vector<trace_event> snapshot();
+
+/**
+ * @brief Discard all recorded events.
+ *
+ * Must not run concurrently with record().
+ */
+void clear();
+
+/**
+ * @brief Write all recorded events to a binary trace file.
+ *
+ * The file holds an 8-byte magic "SQTRACE1", a 64-bit event count and the
+ * events in timestamp order, in host byte order.
+ *
+ * @return true If the file was written completely.
+ */
+bool write(const std::string& path);
+
+/**
+ * @brief Read a trace file produced by write().
+ *
+ * @return true If the file was a complete trace.
+ */
+bool read(const std::string& path, std::vector<trace_event>& events);
+
+namespace detail {
+extern std::atomic<bool> enabled_flag;
+}
+
+inline bool enabled() {
+    return detail::enabled_flag.load(std::memory_order_relaxed);
+}
+
+inline uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace queue_trace
+
+#endif
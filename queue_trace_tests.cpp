@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench.h"
+#include "queue_trace.h"
+
+class QueueTraceTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        queue_trace::clear();
+    }
+
+    void TearDown() override {
+        queue_trace::set_enabled(false);
+        queue_trace::clear();
+    }
+};
+
+TEST_F(QueueTraceTest, SnapshotIsOrderedAcrossThreads) {
+    std::thread other([]() {
+        queue_trace::record(7, trace_op::pop, 200);
+        queue_trace::record(7, trace_op::pop, 400);
+    });
+    other.join();
+    queue_trace::record(7, trace_op::push, 100);
+    queue_trace::record(7, trace_op::push, 300);
+    
+    std::vector<trace_event> events = queue_trace::snapshot();
+    ASSERT_EQ(events.size(), 4u);
+    for (size_t i = 0; i < events.size(); ++i) {
+        EXPECT_EQ(events[i].timestamp_ns, 100u * (i + 1));
+        EXPECT_EQ(events[i].op, static_cast<uint8_t>(i % 2 == 0 ? trace_op::push : trace_op::pop));
+    }
+    EXPECT_NE(events[0].thread_id, events[1].thread_id);
+}
+
+TEST_F(QueueTraceTest, WriteReadRoundTrip) {
+    const uint32_t id = queue_trace::next_queue_id();
+    for (uint64_t t = 1; t <= 10000; ++t) {
+        queue_trace::record(id, t % 3 ? trace_op::push : trace_op::pop, t);
+    }
+    
+    const std::string path = ::testing::TempDir() + "queue_trace_roundtrip.bin";
+    ASSERT_TRUE(queue_trace::write(path));
+    std::vector<trace_event> events;
+    ASSERT_TRUE(queue_trace::read(path, events));
+    std::remove(path.c_str());
+    
+    ASSERT_EQ(events.size(), 10000u);
+    EXPECT_EQ(events.front().queue_id, id);
+    EXPECT_EQ(events.back().timestamp_ns, 10000u);
+}
+
+namespace {
+
+trace_event traced(uint64_t timestamp_ns, uint16_t thread_id, trace_op op) {
+    return trace_event{timestamp_ns, 1, thread_id, static_cast<uint8_t>(op), 0};
+}
+
+}
+
+TEST(ReplayScheduleTest, DropsEarliestSurplusPops) {
+    // Thread 1 pushes twice; threads 2 and 3 pop four times, the first two
+    // taking items pushed before the trace started
+    std::vector<trace_event> events = {
+        traced(100, 2, trace_op::pop), traced(150, 3, trace_op::pop), traced(200, 1, trace_op::push),
+        traced(300, 3, trace_op::pop), traced(400, 1, trace_op::push), traced(500, 2, trace_op::pop),
+    };
+    replay_schedule schedule = make_replay_schedule(events, 1);
+    
+    ASSERT_EQ(schedule.producers.size(), 1u);
+    EXPECT_EQ(schedule.producers[0], (std::vector<uint64_t>{100, 300}));
+    ASSERT_EQ(schedule.consumers.size(), 2u);
+    EXPECT_EQ(schedule.consumers[0], (std::vector<uint64_t>{400}));
+    EXPECT_EQ(schedule.consumers[1], (std::vector<uint64_t>{200}));
+    EXPECT_EQ(schedule.span_ns, 400u);
+}
+
+TEST(ReplayScheduleTest, DrainsLeftoverPushesAtTheEnd) {
+    std::vector<trace_event> events = {
+        traced(100, 1, trace_op::push), traced(200, 1, trace_op::push), traced(250, 2, trace_op::pop),
+        traced(300, 1, trace_op::push), traced(900, 1, trace_op::push),
+    };
+    replay_schedule schedule = make_replay_schedule(events, 1);
+    
+    ASSERT_EQ(schedule.producers.size(), 1u);
+    EXPECT_EQ(schedule.producers[0].size(), 4u);
+    ASSERT_EQ(schedule.consumers.size(), 1u);
+    EXPECT_EQ(schedule.consumers[0], (std::vector<uint64_t>{150, 800, 800, 800}));
+}
@@ -0,0 +1,175 @@
+#ifndef QUEUE_WAIT_H
+#define QUEUE_WAIT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include "fiber.h"
+#include "queue_counters.h"
+
+/**
+ * @brief Which side of a queue a blocked caller waits on.
+ */
+enum class wait_side : int {
+    producer = 0,   ///< Waiting for room
+    consumer = 1    ///< Waiting for an item
+};
+
+/**
+ * @brief Condition variable of a queue that parks fibers instead of blocking their worker.
+ *
+ * Called on a fiber, wait() parks it with this_fiber::suspend() and frees
+ * its worker thread for other fibers; called on a plain thread, it blocks on
+ * a std::condition_variable, so threads and fibers can wait on one queue.
+ * notify_one() resumes the longest-parked fiber, or wakes a thread if no
+ * fiber is parked; notify_all() wakes both. The fiber runtime has no timers,
+ * so timed waits go through native() and block the caller's thread even on
+ * a fiber.
+ *
+ * Every call must hold the queue's mutex.
+ */
+class queue_condition {
+public:
+    queue_condition() = default;
+    queue_condition(const queue_condition&) = delete;
+    queue_condition& operator=(const queue_condition&) = delete;
+
+    /**
+     * @brief Wait until @p ready holds; parks the calling fiber, if any.
+     */
+    template <typename Predicate>
+    void wait(std::unique_lock<std::mutex>& lock, Predicate ready) {
+        fiber* self = this_fiber::current();
+        if (self == nullptr) {
+            threads.wait(lock, ready);
+            return;
+        }
+        while (!ready()) {
+            parked_fiber node{self};
+            if (tail == nullptr) {
+                head = &node;
+            } else {
+                tail->next = &node;
+            }
+            tail = &node;
+            // notify_one() / notify_all() unlink the node before resuming us
+            this_fiber::suspend(lock);
+        }
+    }
+
+    /**
+     * @brief Resume the longest-parked fiber, or wake one waiting thread if none is parked.
+     */
+    void notify_one() {
+        if (!resume_oldest()) {
+            threads.notify_one();
+        }
+    }
+
+    /**
+     * @brief Resume every parked fiber and wake every waiting thread.
+     */
+    void notify_all() {
+        while (resume_oldest()) {
+        }
+        threads.notify_all();
+    }
+
+    /**
+     * @brief Get the condition variable that thread waiters and timed waits block on.
+     */
+    std::condition_variable& native() { return threads; }
+
+private:
+    /// A parked fiber; lives on that fiber's stack
+    struct parked_fiber {
+        fiber* parked;
+        parked_fiber* next = nullptr;
+    };
+
+    bool resume_oldest() {
+        parked_fiber* node = head;
+        if (node == nullptr) {
+            return false;
+        }
+        head = node->next;
+        if (head == nullptr) {
+            tail = nullptr;
+        }
+        fiber_scheduler::resume(node->parked);
+        return true;
+    }
+
+    std::condition_variable threads;    ///< Plain threads and timed waits block here
+    parked_fiber* head = nullptr;       ///< Oldest parked fiber
+    parked_fiber* tail = nullptr;       ///< Newest parked fiber
+};
+
+/**
+ * @brief Counts the caller as blocked on one side of a queue while in scope.
+ *
+ * Maintains waiting_producers / waiting_consumers and the matching
+ * blocked-since stamp of a queue_counters, as queue_watchdog expects. The
+ * queue's mutex must be held when the scope begins and ends.
+ */
+class counted_wait_scope {
+public:
+    counted_wait_scope(queue_counters& counters, wait_side side)
+        : waiting(side == wait_side::producer ? counters.waiting_producers : counters.waiting_consumers),
+          since_ns(side == wait_side::producer ? counters.producers_blocked_since_ns
+                                               : counters.consumers_blocked_since_ns) {
+        begin_counted_wait(waiting, since_ns);
+    }
+
+    ~counted_wait_scope() { end_counted_wait(waiting, since_ns); }
+
+    counted_wait_scope(const counted_wait_scope&) = delete;
+    counted_wait_scope& operator=(const counted_wait_scope&) = delete;
+
+private:
+    std::atomic<uint32_t>& waiting;
+    std::atomic<int64_t>& since_ns;
+};
+
+/**
+ * @brief Block on @p cv until @p ready holds, counted as a waiter on @p side.
+ *
+ * @tparam Condition std::condition_variable or queue_condition.
+ *
+ * Returns at once, without touching the counters, if @p ready already holds.
+ */
+template <typename Condition, typename Predicate>
+void counted_wait(Condition& cv, std::unique_lock<std::mutex>& lock, Predicate ready,
+                  queue_counters& counters, wait_side side) {
+    if (ready()) {
+        return;
+    }
+    counted_wait_scope scope(counters, side);
+    cv.wait(lock, ready);
+}
+
+/**
+ * @brief Block on @p cv until @p ready holds or @p deadline passes, counted as a waiter on @p side.
+ *
+ * @tparam Clock Clock policy that performs the wait (see queue_clock.h).
+ * @return bool The final value of @p ready; a false result counts as a timeout.
+ */
+template <typename Clock, typename Predicate>
+bool counted_wait_until(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, Predicate ready,
+                        typename Clock::time_point deadline, queue_counters& counters, wait_side side) {
+    if (ready()) {
+        return true;
+    }
+    bool satisfied;
+    {
+        counted_wait_scope scope(counters, side);
+        satisfied = Clock::wait_until(cv, lock, deadline, ready);
+    }
+    if (!satisfied) {
+        bump_counter(counters.timeouts);
+    }
+    return satisfied;
+}
+
+#endif
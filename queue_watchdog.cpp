@@ -0,0 +1,152 @@
+#include "queue_watchdog.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+int64_t steady_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void print_to_stderr(const stall_report& report) {
+    std::cerr << report << "\n";
+}
+
+} // namespace
+
+std::ostream& operator<<(std::ostream& out, const stall_report& report) {
+    auto ago_ms = [&report](int64_t ns) {
+        return ns == 0 ? -1 : (report.detected_ns - ns) / 1000000;
+    };
+    out << "queue watchdog: " << report.name << ": "
+        << (report.kind == stall_kind::consumer_stalled ? "consumer stalled" : "producers blocked")
+        << " depth=" << report.depth << "/" << report.capacity
+        << " waiting_producers=" << report.waiting_producers
+        << " waiting_consumers=" << report.waiting_consumers
+        << " pushes=" << report.pushes
+        << " pops=" << report.pops
+        << " last_push_ms_ago=" << ago_ms(report.last_push_ns)
+        << " last_pop_ms_ago=" << ago_ms(report.last_pop_ns)
+        << " producers_blocked_ms=" << ago_ms(report.producers_blocked_since_ns);
+    return out;
+}
+
+queue_watchdog::queue_watchdog() : queue_watchdog(options()) {}
+
+queue_watchdog::queue_watchdog(const options& opts, handler on_stall)
+    : opts(opts), on_stall(on_stall ? std::move(on_stall) : handler(print_to_stderr)) {}
+
+queue_watchdog::~queue_watchdog() {
+    stop();
+}
+
+void queue_watchdog::watch(const std::string& name, const queue_counters& counters) {
+    const int64_t now = steady_now_ns();
+    std::lock_guard<std::mutex> lock(mutex);
+    queues.push_back(watched_queue{name, &counters,
+                                   counters.pushes.load(std::memory_order_relaxed),
+                                   counters.pops.load(std::memory_order_relaxed),
+                                   now, now, false, false});
+}
+
+void queue_watchdog::unwatch(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    queues.erase(std::remove_if(queues.begin(), queues.end(),
+                                [&name](const watched_queue& q) { return q.name == name; }),
+                 queues.end());
+}
+
+void queue_watchdog::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) {
+        return;
+    }
+    running = true;
+    worker = std::thread(&queue_watchdog::run, this);
+}
+
+void queue_watchdog::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            return;
+        }
+        running = false;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+size_t queue_watchdog::check_now() {
+    return check_now(steady_now_ns());
+}
+
+size_t queue_watchdog::check_now(int64_t now_ns) {
+    const int64_t no_pop_ns = std::chrono::nanoseconds(opts.no_pop_threshold).count();
+    const int64_t blocked_ns = std::chrono::nanoseconds(opts.blocked_producer_threshold).count();
+    std::vector<stall_report> reports;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (watched_queue& q : queues) {
+            const queue_counters& c = *q.counters;
+            const uint64_t pushes = c.pushes.load(std::memory_order_relaxed);
+            const uint64_t pops = c.pops.load(std::memory_order_relaxed);
+            const size_t depth = c.depth.load(std::memory_order_relaxed);
+            const uint32_t waiting_producers = c.waiting_producers.load(std::memory_order_relaxed);
+            const int64_t blocked_since = waiting_producers == 0
+                ? 0 : c.producers_blocked_since_ns.load(std::memory_order_relaxed);
+
+            if (pushes != q.pushes) {
+                q.pushes = pushes;
+                q.last_push_ns = now_ns;
+            }
+            if (pops != q.pops) {
+                q.pops = pops;
+                q.last_pop_ns = now_ns;
+                q.consumer_reported = false;
+                q.producers_reported = false;
+            }
+            if (blocked_since == 0) {
+                q.producers_reported = false;
+            }
+            // With several producers the waiter count may never drop to zero
+            // while pops keep admitting them one at a time, so the episode
+            // restarts at every pop
+            const int64_t stuck_since = std::max(blocked_since, q.last_pop_ns);
+
+            stall_report report{q.name, stall_kind::consumer_stalled, depth,
+                                c.capacity.load(std::memory_order_relaxed), waiting_producers,
+                                c.waiting_consumers.load(std::memory_order_relaxed),
+                                pushes, pops, q.last_push_ns, q.last_pop_ns, blocked_since, now_ns};
+
+            if (depth > 0 && !q.consumer_reported && now_ns - q.last_pop_ns >= no_pop_ns) {
+                q.consumer_reported = true;
+                reports.push_back(report);
+            }
+            if (blocked_since != 0 && !q.producers_reported && now_ns - stuck_since >= blocked_ns) {
+                q.producers_reported = true;
+                report.kind = stall_kind::producers_blocked;
+                reports.push_back(report);
+            }
+        }
+    }
+    for (const stall_report& report : reports) {
+        on_stall(report);
+    }
+    return reports.size();
+}
+
+void queue_watchdog::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        wake.wait_for(lock, opts.poll_interval, [this] { return !running; });
+        if (!running) {
+            break;
+        }
+        lock.unlock();
+        check_now();
+        lock.lock();
+    }
+}
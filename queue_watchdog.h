@@ -0,0 +1,161 @@
+#ifndef QUEUE_WATCHDOG_H
+#define QUEUE_WATCHDOG_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "queue_counters.h"
+
+/**
+ * @brief Kind of no-progress condition reported by queue_watchdog.
+ */
+enum class stall_kind {
+    consumer_stalled,       ///< Queue is non-empty but nothing was popped for no_pop_threshold
+    producers_blocked       ///< Producers blocked on a full queue and no pop for blocked_producer_threshold
+};
+
+/**
+ * @brief Snapshot of a stalled queue, passed to the watchdog handler.
+ *
+ * Timestamps are steady_clock nanoseconds since epoch. last_push_ns and
+ * last_pop_ns are when the watchdog last saw the counters move, so they are
+ * accurate to one poll interval.
+ */
+struct stall_report {
+    std::string name;                       ///< Name the queue was registered under
+    stall_kind kind;                        ///< Condition that triggered the report
+    size_t depth;                           ///< Items queued
+    size_t capacity;                        ///< Maximum number of items
+    uint32_t waiting_producers;             ///< Producers blocked on a full queue
+    uint32_t waiting_consumers;             ///< Consumers blocked on an empty queue
+    uint64_t pushes;                        ///< Items pushed so far
+    uint64_t pops;                          ///< Items popped so far
+    int64_t last_push_ns;                   ///< Last observed push activity
+    int64_t last_pop_ns;                    ///< Last observed pop activity
+    int64_t producers_blocked_since_ns;     ///< Start of the current producer blocking, 0 if none
+    int64_t detected_ns;                    ///< When the stall was detected
+};
+
+/**
+ * @brief Write a one-line description of a stall report.
+ */
+std::ostream& operator<<(std::ostream& out, const stall_report& report);
+
+/**
+ * @brief Optional background thread that detects stuck queues.
+ *
+ * The watchdog samples the lock-free queue_counters of each registered queue
+ * every poll_interval and never touches the queue's mutex, so watching a
+ * queue costs the data path nothing beyond the counters themselves. Each
+ * stall episode is reported once; a queue is reported again only after it
+ * has made progress and stalled anew.
+ *
+ * Registered counters must outlive their registration (call unwatch() or
+ * stop() before destroying a watched queue).
+ */
+class queue_watchdog {
+public:
+    /**
+     * @brief Detection thresholds.
+     */
+    struct options {
+        std::chrono::milliseconds poll_interval{100};                  ///< Sampling period
+        std::chrono::milliseconds no_pop_threshold{1000};              ///< Non-empty with no pops for this long
+        std::chrono::milliseconds blocked_producer_threshold{1000};    ///< Producers blocked with no pop for this long
+    };
+
+    using handler = std::function<void(const stall_report&)>;
+
+    /**
+     * @brief Construct a watchdog that reports stalls to stderr.
+     */
+    queue_watchdog();
+
+    /**
+     * @brief Construct a watchdog with custom thresholds and report handler.
+     *
+     * @param opts Detection thresholds.
+     * @param on_stall Called from the watchdog thread for each stall; an empty
+     *        handler falls back to printing to stderr.
+     */
+    explicit queue_watchdog(const options& opts, handler on_stall = handler());
+
+    /**
+     * @brief Stop the thread if it is running.
+     */
+    ~queue_watchdog();
+
+    queue_watchdog(const queue_watchdog&) = delete;
+    queue_watchdog& operator=(const queue_watchdog&) = delete;
+
+    /**
+     * @brief Register counters to monitor under @p name.
+     */
+    void watch(const std::string& name, const queue_counters& counters);
+
+    /**
+     * @brief Register any queue exposing counters(), such as safe_queue.
+     */
+    template <typename Queue>
+    void watch(const std::string& name, const Queue& queue) {
+        watch(name, queue.counters());
+    }
+
+    /**
+     * @brief Stop monitoring the queue registered under @p name.
+     */
+    void unwatch(const std::string& name);
+
+    /**
+     * @brief Start the background thread; no-op if already running.
+     */
+    void start();
+
+    /**
+     * @brief Stop and join the background thread; no-op if not running.
+     */
+    void stop();
+
+    /**
+     * @brief Sample every watched queue once on the calling thread.
+     *
+     * @param now_ns Sampling time in steady_clock nanoseconds.
+     * @return size_t Number of stalls reported by this sample.
+     */
+    size_t check_now(int64_t now_ns);
+
+    /**
+     * @brief Sample every watched queue once at the current time.
+     */
+    size_t check_now();
+
+private:
+    struct watched_queue {
+        std::string name;
+        const queue_counters* counters;
+        uint64_t pushes;                ///< Counter values at the last sample
+        uint64_t pops;
+        int64_t last_push_ns;           ///< When pushes last changed
+        int64_t last_pop_ns;            ///< When pops last changed
+        bool consumer_reported;         ///< Current episode already reported
+        bool producers_reported;
+    };
+
+    void run();
+
+    options opts;
+    handler on_stall;
+    std::mutex mutex;                   ///< Guards queues and running
+    std::condition_variable wake;
+    std::vector<watched_queue> queues;
+    bool running = false;
+    std::thread worker;
+};
+
+#endif
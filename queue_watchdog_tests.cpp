@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <thread>
+#include <vector>
+#include "enqueue.h"
+#include "queue_watchdog.h"
+
+namespace {
+
+constexpr int64_t ms = 1000000;
+
+queue_watchdog::options test_options() {
+    queue_watchdog::options opts;
+    opts.poll_interval = std::chrono::milliseconds(5);
+    opts.no_pop_threshold = std::chrono::milliseconds(50);
+    opts.blocked_producer_threshold = std::chrono::milliseconds(50);
+    return opts;
+}
+
+} // namespace
+
+TEST(QueueWatchdogTest, ReportsNonEmptyQueueWithoutPopsOnce) {
+    std::vector<stall_report> reports;
+    queue_watchdog watchdog(test_options(), [&reports](const stall_report& r) { reports.push_back(r); });
+    safe_queue<int> q(4);
+    watchdog.watch("jobs", q);
+    const int64_t start = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    q.push(1);
+    EXPECT_EQ(watchdog.check_now(start + 10 * ms), 0u);
+    EXPECT_EQ(watchdog.check_now(start + 100 * ms), 1u);
+    EXPECT_EQ(watchdog.check_now(start + 200 * ms), 0u);  // same episode
+
+    ASSERT_EQ(reports.size(), 1u);
+    EXPECT_EQ(reports[0].name, "jobs");
+    EXPECT_EQ(reports[0].kind, stall_kind::consumer_stalled);
+    EXPECT_EQ(reports[0].depth, 1u);
+    EXPECT_EQ(reports[0].capacity, 4u);
+    EXPECT_EQ(reports[0].pushes, 1u);
+    EXPECT_EQ(reports[0].pops, 0u);
+
+    // Progress ends the episode; a new stall is reported again.
+    q.pop();
+    q.push(2);
+    q.push(3);
+    EXPECT_EQ(watchdog.check_now(start + 210 * ms), 0u);
+    EXPECT_EQ(watchdog.check_now(start + 300 * ms), 1u);
+    EXPECT_EQ(reports.size(), 2u);
+}
+
+TEST(QueueWatchdogTest, EmptyQueueIsNotStalled) {
+    size_t reports = 0;
+    queue_watchdog watchdog(test_options(), [&reports](const stall_report&) { ++reports; });
+    safe_queue<int> q(4);
+    watchdog.watch("idle", q);
+    EXPECT_EQ(watchdog.check_now(), 0u);
+    q.push(1);
+    q.pop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_EQ(watchdog.check_now(), 0u);
+    EXPECT_EQ(reports, 0u);
+}
+
+TEST(QueueWatchdogTest, BackgroundThreadReportsBlockedProducers) {
+    std::atomic<int> consumer_stalls(0);
+    std::atomic<int> producer_stalls(0);
+    std::atomic<uint32_t> waiting_seen(0);
+    queue_watchdog watchdog(test_options(), [&](const stall_report& r) {
+        if (r.kind == stall_kind::producers_blocked) {
+            waiting_seen = r.waiting_producers;
+            ++producer_stalls;
+        } else {
+            ++consumer_stalls;
+        }
+    });
+    safe_queue<int> q(1);
+    watchdog.watch("full", q);
+    watchdog.start();
+
+    q.push(1);
+    std::thread producer([&q] { q.push(2); });
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (producer_stalls == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(q.counters().waiting_producers.load(), 1u);
+    q.pop();
+    producer.join();
+    watchdog.stop();
+
+    EXPECT_EQ(producer_stalls, 1);
+    EXPECT_EQ(waiting_seen, 1u);
+    EXPECT_EQ(consumer_stalls, 1);
+    EXPECT_EQ(q.counters().waiting_producers.load(), 0u);
+    EXPECT_EQ(q.counters().producers_blocked_since_ns.load(), 0);
+}
+
+TEST(QueueWatchdogTest, DrainedQueueWithManyProducersIsNotBlocked) {
+    std::vector<stall_report> reports;
+    queue_watchdog watchdog(test_options(), [&reports](const stall_report& r) {
+        if (r.kind == stall_kind::producers_blocked) {
+            reports.push_back(r);
+        }
+    });
+    safe_queue<int> q(1);
+    watchdog.watch("busy", q);
+    const int64_t start = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    q.push(0);
+    std::vector<std::thread> producers;
+    for (int i = 1; i <= 3; ++i) {
+        producers.emplace_back([&q, i] { q.push(i); });
+    }
+    auto wait_for_waiting = [&q](uint32_t n) {
+        while (q.counters().waiting_producers.load() != n) {
+            std::this_thread::yield();
+        }
+    };
+    wait_for_waiting(3);
+    EXPECT_EQ(watchdog.check_now(start + 10 * ms), 0u);
+
+    // Each pop admits one producer; the others stay blocked throughout.
+    q.pop();
+    wait_for_waiting(2);
+    EXPECT_EQ(watchdog.check_now(start + 100 * ms), 0u);
+    q.pop();
+    wait_for_waiting(1);
+    EXPECT_EQ(watchdog.check_now(start + 200 * ms), 0u);
+    EXPECT_TRUE(reports.empty());
+
+    // Pops stop while a producer is still blocked.
+    watchdog.check_now(start + 260 * ms);
+    ASSERT_EQ(reports.size(), 1u);
+    EXPECT_EQ(reports[0].waiting_producers, 1u);
+
+    q.pop();
+    q.pop();
+    for (std::thread& t : producers) {
+        t.join();
+    }
+}
+
+TEST(QueueWatchdogTest, UnwatchStopsReports) {
+    size_t reports = 0;
+    queue_watchdog watchdog(test_options(), [&reports](const stall_report&) { ++reports; });
+    safe_queue<int> q(4);
+    watchdog.watch("gone", q);
+    q.push(1);
+    watchdog.unwatch("gone");
+    EXPECT_EQ(watchdog.check_now(std::numeric_limits<int64_t>::max()), 0u);
+    EXPECT_EQ(reports, 0u);
+}
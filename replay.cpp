@@ -0,0 +1,152 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "queue_trace.h"
+
+namespace {
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " TRACE [options]\n"
+              << "Replays the push/pop pattern of one traced queue against queue variants.\n"
+              << "  --list              list the queues in the trace and exit\n"
+              << "  --queue-id ID       traced queue to replay (default: the busiest)\n"
+              << "  --queue NAME        variant to replay against (default: every variant)\n"
+              << "  --capacity N        queue capacity in items (default 1024)\n"
+              << "  --payload BYTES     payload bytes copied with each item (default 0)\n"
+              << "  --speed X           replay X times faster than recorded (default 1)\n"
+              << "  --pin               pin each thread to its own CPU\n"
+              << "  --no-counters       skip hardware performance counters\n"
+              << "  --format FORMAT     json or csv (default json)\n"
+              << "  --output FILE       write results to FILE instead of stdout\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2 || std::string(argv[1]) == "--help" || std::string(argv[1]) == "-h") {
+        print_usage(argv[0]);
+        return argc < 2 ? 2 : 0;
+    }
+
+    std::vector<trace_event> events;
+    if (!queue_trace::read(argv[1], events)) {
+        std::cerr << "Cannot read trace " << argv[1] << "\n";
+        return 1;
+    }
+
+    bench_config config;
+    std::vector<queue_variant> variants = all_variants();
+    std::string format = "json";
+    std::string output;
+    double speed = 1.0;
+    bool list = false;
+    bool have_queue_id = false;
+    uint32_t queue_id = 0;
+
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        char* end = nullptr;
+        bool ok = true;
+
+        if (arg == "--list") {
+            list = true;
+            continue;
+        } else if (arg == "--pin") {
+            config.pin = true;
+            continue;
+        } else if (arg == "--no-counters") {
+            config.counters = false;
+            continue;
+        } else if (value == nullptr) {
+            ok = false;
+        } else if (arg == "--queue-id") {
+            queue_id = static_cast<uint32_t>(std::strtoul(value, &end, 10));
+            ok = *end == '\0';
+            have_queue_id = true;
+        } else if (arg == "--queue") {
+            ok = parse_variant(value, config.variant);
+            variants.assign(1, config.variant);
+        } else if (arg == "--capacity") {
+            config.capacity = static_cast<size_t>(std::strtoull(value, &end, 10));
+            ok = *end == '\0' && config.capacity > 0;
+        } else if (arg == "--payload") {
+            config.payload_size = static_cast<size_t>(std::strtoull(value, &end, 10));
+            ok = *end == '\0';
+        } else if (arg == "--speed") {
+            speed = std::strtod(value, &end);
+            ok = *end == '\0' && speed > 0.0;
+        } else if (arg == "--format") {
+            format = value;
+            ok = format == "json" || format == "csv";
+        } else if (arg == "--output") {
+            output = value;
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            std::cerr << "Invalid or incomplete option: " << arg << "\n";
+            print_usage(argv[0]);
+            return 2;
+        }
+        ++i;
+    }
+
+    std::map<uint32_t, size_t> event_counts;
+    for (const trace_event& event : events) {
+        ++event_counts[event.queue_id];
+    }
+    if (list) {
+        for (const auto& entry : event_counts) {
+            std::cout << "queue " << entry.first << ": " << entry.second << " events\n";
+        }
+        return 0;
+    }
+    if (event_counts.empty()) {
+        std::cerr << "Trace " << argv[1] << " contains no events\n";
+        return 1;
+    }
+    if (!have_queue_id) {
+        size_t busiest = 0;
+        for (const auto& entry : event_counts) {
+            if (entry.second > busiest) {
+                busiest = entry.second;
+                queue_id = entry.first;
+            }
+        }
+    }
+
+    replay_schedule schedule = make_replay_schedule(events, queue_id);
+    if (schedule.producers.empty()) {
+        std::cerr << "Queue " << queue_id << " has no push events in the trace\n";
+        return 1;
+    }
+
+    std::vector<bench_result> results;
+    for (queue_variant variant : variants) {
+        config.variant = variant;
+        results.push_back(run_replay(config, schedule, speed));
+    }
+
+    std::ofstream file;
+    if (!output.empty()) {
+        file.open(output);
+        if (!file) {
+            std::cerr << "Cannot open " << output << " for writing\n";
+            return 1;
+        }
+    }
+    std::ostream& out = output.empty() ? std::cout : file;
+
+    if (format == "csv") {
+        write_csv(out, results);
+    } else {
+        write_json(out, results);
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+#ifndef RING_MEMORY_H
+#define RING_MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/**
+ * @brief Page-granular backing memory for large, lazily used ring buffers.
+ *
+ * reserve() maps anonymous memory without reserving swap, so the kernel only
+ * commits a page when it is first written. A ring that constructs its slots
+ * on demand therefore keeps its resident size proportional to the slots it
+ * has actually used, however large its capacity.
+ */
+namespace ring_memory {
+
+/**
+ * @brief Get the system page size in bytes.
+ */
+inline size_t page_size() {
+    static const size_t size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+/**
+ * @brief Reserve @p bytes of address space, committed page by page on first write.
+ *
+ * @return void* The zero-filled region, or nullptr if it could not be mapped.
+ */
+inline void* reserve(size_t bytes) {
+    void* region = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return region == MAP_FAILED ? nullptr : region;
+}
+
+/**
+ * @brief Unmap a region returned by reserve().
+ */
+inline void release(void* region, size_t bytes) {
+    ::munmap(region, bytes);
+}
+
+/**
+ * @brief Return the whole pages inside [@p begin, @p begin + @p bytes) to the kernel.
+ *
+ * The pages stay mapped and read back as zeros; partial pages at either end
+ * are left alone.
+ */
+inline void discard(void* begin, size_t bytes) {
+    const uintptr_t page = page_size();
+    const uintptr_t start = (reinterpret_cast<uintptr_t>(begin) + page - 1) & ~(page - 1);
+    const uintptr_t end = (reinterpret_cast<uintptr_t>(begin) + bytes) & ~(page - 1);
+    if (end > start) {
+        ::madvise(reinterpret_cast<void*>(start), end - start, MADV_DONTNEED);
+    }
+}
+
+} // namespace ring_memory
+
+#endif
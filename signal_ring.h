@@ -0,0 +1,195 @@
+#ifndef SIGNAL_RING_H
+#define SIGNAL_RING_H
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <type_traits>
+#include <unistd.h>
+#include "enqueue.h"
+
+/**
+ * @brief A bounded multi-producer, single-consumer ring that signal handlers may push to.
+ *
+ * @tparam T The record type; must be trivially copyable.
+ *
+ * safe_queue::push takes mutex_sync, so a signal handler that pushes while
+ * the interrupted thread holds the mutex deadlocks. signal_ring::push takes
+ * no lock, never allocates, never blocks and leaves errno untouched, so it is
+ * async-signal-safe. Producers claim a slot with a compare-and-swap on the
+ * tail index and publish it through a per-slot sequence number; a retry
+ * happens only when another producer claimed the slot first, and a full ring
+ * drops the record (counted by dropped()) rather than waiting.
+ *
+ * A push interrupted between claiming and publishing its slot does not block
+ * a nested push from its own signal handler, which claims the next slot; the
+ * consumer sees the later records once the interrupted push completes.
+ *
+ * One ordinary thread drains the ring with try_pop(). Its timed variant
+ * sleeps on a futex, and a push wakes it with one syscall only if it is
+ * actually asleep; push_no_wake() skips that check for consumers that only
+ * poll. All memory is allocated by the constructor.
+ */
+template <typename T>
+class signal_ring {
+    static_assert(std::is_trivially_copyable<T>::value, "signal_ring records must be trivially copyable");
+    static_assert(std::atomic<size_t>::is_always_lock_free, "signal_ring needs lock-free atomics");
+
+public:
+    /**
+     * @brief Construct a ring of at least @p min_capacity records, rounded up to a power of two.
+     */
+    explicit signal_ring(size_t min_capacity) : mask(round_up(min_capacity) - 1), slots(new slot[mask + 1]) {
+        for (size_t i = 0; i <= mask; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~signal_ring() { delete[] slots; }
+
+    signal_ring(const signal_ring&) = delete;
+    signal_ring& operator=(const signal_ring&) = delete;
+
+    /**
+     * @brief Append a record; async-signal-safe.
+     *
+     * @return bool false if the ring was full and the record was dropped.
+     */
+    bool push(const T& record) {
+        if (!push_no_wake(record)) {
+            return false;
+        }
+        wake_consumer();
+        return true;
+    }
+
+    /**
+     * @brief Append a record without waking a consumer sleeping in the timed try_pop(); async-signal-safe.
+     *
+     * Skips push()'s fence and wake-up check, for rings whose consumer only
+     * polls with the non-blocking try_pop().
+     *
+     * @return bool false if the ring was full and the record was dropped.
+     */
+    bool push_no_wake(const T& record) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        slot* target;
+        for (;;) {
+            target = &slots[position & mask];
+            const size_t sequence = target->sequence.load(std::memory_order_acquire);
+            const intptr_t lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (lag == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                dropped_records.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+        target->record = record;
+        target->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Take the oldest published record without waiting; consumer thread only.
+     *
+     * @return bool false if no record is ready.
+     */
+    bool try_pop(T& record) {
+        slot& source = slots[head & mask];
+        if (source.sequence.load(std::memory_order_acquire) != head + 1) {
+            return false;
+        }
+        record = source.record;
+        source.sequence.store(head + mask + 1, std::memory_order_release);
+        ++head;
+        return true;
+    }
+
+    /**
+     * @brief Take the oldest record, sleeping at most @p timeout for one; consumer thread only.
+     *
+     * @return queue_status::ok or queue_status::timeout.
+     */
+    queue_status try_pop(T& record, const std::chrono::milliseconds& timeout) {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!try_pop(record)) {
+            const auto left = deadline - std::chrono::steady_clock::now();
+            if (left <= std::chrono::steady_clock::duration::zero()) {
+                return queue_status::timeout;
+            }
+            consumer_asleep.store(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ready()) {
+                consumer_asleep.store(0, std::memory_order_relaxed);
+                continue;
+            }
+            const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+            struct timespec relative;
+            relative.tv_sec = static_cast<time_t>(ns / 1000000000);
+            relative.tv_nsec = static_cast<long>(ns % 1000000000);
+            ::syscall(SYS_futex, futex_word(), FUTEX_WAIT_PRIVATE, 1, &relative, nullptr, 0);
+            consumer_asleep.store(0, std::memory_order_relaxed);
+        }
+        return queue_status::ok;
+    }
+
+    /**
+     * @brief Get the number of records dropped because the ring was full.
+     */
+    uint64_t dropped() const { return dropped_records.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Get the number of record slots.
+     */
+    size_t capacity() const { return mask + 1; }
+
+private:
+    struct slot {
+        std::atomic<size_t> sequence;   ///< position + 1 once published, position + capacity once consumed
+        T record;
+    };
+
+    static size_t round_up(size_t n) {
+        size_t capacity = 2;
+        while (capacity < n) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    bool ready() const {
+        return slots[head & mask].sequence.load(std::memory_order_acquire) == head + 1;
+    }
+
+    uint32_t* futex_word() { return reinterpret_cast<uint32_t*>(&consumer_asleep); }
+
+    /// Wake the consumer if it sleeps in try_pop(); preserves errno.
+    void wake_consumer() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (consumer_asleep.load(std::memory_order_relaxed) != 0 &&
+            consumer_asleep.exchange(0, std::memory_order_relaxed) != 0) {
+            const int saved_errno = errno;
+            ::syscall(SYS_futex, futex_word(), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+            errno = saved_errno;
+        }
+    }
+
+    const size_t mask;                          ///< Capacity - 1
+    slot* const slots;                          ///< Ring of records with their sequence numbers
+    alignas(64) std::atomic<size_t> tail{0};    ///< Next position producers claim
+    alignas(64) size_t head = 0;                ///< Next position the consumer reads
+    std::atomic<uint32_t> consumer_asleep{0};   ///< 1 while the consumer sleeps on it (futex word)
+    std::atomic<uint64_t> dropped_records{0};   ///< Records rejected by a full ring
+};
+
+#endif
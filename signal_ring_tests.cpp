@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <thread>
+#include <vector>
+#include "signal_ring.h"
+
+using std::chrono::milliseconds;
+
+namespace {
+
+struct sample {
+    int signal;
+    uint64_t sequence;
+};
+
+signal_ring<sample>* handler_ring = nullptr;
+uint64_t handler_calls = 0;
+
+void record_signal(int signo) {
+    errno = EINTR;
+    handler_ring->push(sample{signo, ++handler_calls});
+}
+
+}  // namespace
+
+TEST(SignalRingTest, PushFromSignalHandler) {
+    signal_ring<sample> ring(8);
+    handler_ring = &ring;
+    handler_calls = 0;
+    struct sigaction action = {};
+    struct sigaction previous = {};
+    action.sa_handler = record_signal;
+    sigemptyset(&action.sa_mask);
+    ASSERT_EQ(sigaction(SIGUSR1, &action, &previous), 0);
+
+    std::raise(SIGUSR1);
+    std::raise(SIGUSR1);
+    sigaction(SIGUSR1, &previous, nullptr);
+    handler_ring = nullptr;
+
+    sample s{};
+    ASSERT_TRUE(ring.try_pop(s));
+    EXPECT_EQ(s.signal, SIGUSR1);
+    EXPECT_EQ(s.sequence, 1u);
+    ASSERT_TRUE(ring.try_pop(s));
+    EXPECT_EQ(s.sequence, 2u);
+    EXPECT_FALSE(ring.try_pop(s));
+}
+
+TEST(SignalRingTest, DropsWhenFull) {
+    signal_ring<int> ring(3);
+    EXPECT_EQ(ring.capacity(), 4u);
+    for (int i = 0; i < 6; ++i) {
+        ring.push(i);
+    }
+    EXPECT_EQ(ring.dropped(), 2u);
+
+    int val = -1;
+    for (int expected = 0; expected < 4; ++expected) {
+        ASSERT_TRUE(ring.try_pop(val));
+        EXPECT_EQ(val, expected);
+    }
+    EXPECT_TRUE(ring.push(9));
+}
+
+TEST(SignalRingTest, PushPreservesErrno) {
+    signal_ring<int> ring(4);
+    std::thread consumer([&ring]() {
+        int val = 0;
+        EXPECT_EQ(ring.try_pop(val, milliseconds(5000)), queue_status::ok);
+    });
+    std::this_thread::sleep_for(milliseconds(20));
+    errno = EINTR;
+    ring.push(1);
+    EXPECT_EQ(errno, EINTR);
+    consumer.join();
+}
+
+TEST(SignalRingTest, TimedPopTimesOut) {
+    signal_ring<int> ring(4);
+    int val = 0;
+    EXPECT_EQ(ring.try_pop(val, milliseconds(10)), queue_status::timeout);
+}
+
+TEST(SignalRingTest, ManyProducersOneConsumer) {
+    signal_ring<uint64_t> ring(1024);
+    const int producers = 4;
+    const uint64_t per_producer = 20000;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&ring, p, per_producer]() {
+            for (uint64_t i = 0; i < per_producer; ++i) {
+                while (!ring.push(static_cast<uint64_t>(p) << 32 | i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<uint64_t> next(producers, 0);
+    uint64_t received = 0;
+    while (received < producers * per_producer) {
+        uint64_t val = 0;
+        ASSERT_EQ(ring.try_pop(val, milliseconds(5000)), queue_status::ok);
+        const size_t p = static_cast<size_t>(val >> 32);
+        EXPECT_EQ(val & 0xffffffffu, next[p]++);
+        ++received;
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+TEST(SignalRingTest, PushNoWakeIsVisibleToPolling) {
+    signal_ring<int> ring(4);
+    EXPECT_TRUE(ring.push_no_wake(5));
+    int val = 0;
+    ASSERT_TRUE(ring.try_pop(val));
+    EXPECT_EQ(val, 5);
+}
@@ -0,0 +1,275 @@
+#ifndef TTL_QUEUE_H
+#define TTL_QUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include "enqueue.h"
+#include "queue_clock.h"
+#include "queue_counters.h"
+#include "queue_wait.h"
+
+/**
+ * @brief A fixed-capacity thread-safe FIFO queue whose items expire.
+ *
+ * @tparam T The type of elements stored in the queue.
+ * @tparam Clock Clock policy used for expiry and the timed operations (see
+ *         queue_clock.h); virtual_clock makes expiry testable without sleeping.
+ *
+ * Every item is stamped with an expiry time when it is pushed, from the
+ * queue's default time-to-live or a per-item one. Expired items are evicted
+ * lazily: a pop discards the expired run at the head before returning the
+ * first live item, and purge_expired() does the same in bulk. Eviction stops
+ * at the first live item, so it costs O(expired) and never touches live
+ * items; an expired item behind a longer-lived one is evicted when it reaches
+ * the head. Evicted items count as counters().expired, not as pops.
+ */
+template <typename T, typename Clock = steady_clock_policy>
+class ttl_queue {
+public:
+    using time_point = typename Clock::time_point;
+
+    /**
+     * @brief Construct a queue whose items live for @p default_ttl.
+     *
+     * @param max_capacity The maximum number of items, live or expired.
+     * @param default_ttl Time-to-live of items pushed without one; zero means
+     *        they never expire.
+     */
+    ttl_queue(size_t max_capacity, std::chrono::milliseconds default_ttl)
+        : slots(new slot[max_capacity]), maximum_capacity(max_capacity), default_ttl(default_ttl) {
+        counters_data.capacity.store(maximum_capacity, std::memory_order_relaxed);
+    }
+
+    ~ttl_queue() { delete[] slots; }
+
+    ttl_queue(const ttl_queue&) = delete;
+    ttl_queue& operator=(const ttl_queue&) = delete;
+
+    /**
+     * @brief Push an item with the default time-to-live, blocking while the queue is full.
+     *
+     * @return queue_status::ok or queue_status::closed.
+     */
+    queue_status push(T item) { return push(std::move(item), default_ttl); }
+
+    /**
+     * @brief Push an item that expires after @p ttl (zero: never), blocking while the queue is full.
+     *
+     * Expired items at the head are evicted to make room, and a producer
+     * blocked on a full queue wakes when the head item expires.
+     *
+     * @return queue_status::ok or queue_status::closed.
+     */
+    queue_status push(T item, std::chrono::milliseconds ttl) {
+        std::unique_lock<std::mutex> lock(mutex_sync);
+        await_room_locked(lock, nullptr);
+        if (closed_flag) {
+            return queue_status::closed;
+        }
+        enqueue_locked(std::move(item), ttl);
+        return queue_status::ok;
+    }
+
+    /**
+     * @brief Push an item with the default time-to-live, waiting at most @p timeout for room.
+     *
+     * @return queue_status::ok, queue_status::timeout or queue_status::closed.
+     */
+    queue_status try_push(T item, const std::chrono::milliseconds& timeout) {
+        return try_push(std::move(item), default_ttl, timeout);
+    }
+
+    /**
+     * @brief Push an item that expires after @p ttl (zero: never), waiting at most @p timeout for room.
+     *
+     * @return queue_status::ok, queue_status::timeout or queue_status::closed.
+     */
+    queue_status try_push(T item, std::chrono::milliseconds ttl, const std::chrono::milliseconds& timeout) {
+        std::unique_lock<std::mutex> lock(mutex_sync);
+        const time_point deadline = Clock::now() + timeout;
+        if (!await_room_locked(lock, &deadline)) {
+            return queue_status::timeout;
+        }
+        if (closed_flag) {
+            return queue_status::closed;
+        }
+        enqueue_locked(std::move(item), ttl);
+        return queue_status::ok;
+    }
+
+    /**
+     * @brief Pop the oldest live item, blocking until there is one or the queue is closed and drained.
+     *
+     * @return queue_status::ok If an item was moved into @p item.
+     * @return queue_status::closed If the queue is closed and holds no live items.
+     */
+    queue_status pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_sync);
+        counted_wait(not_empty, lock, [this]() { return closed_flag || has_live_locked(); },
+                     counters_data, wait_side::consumer);
+        if (!has_live_locked()) {
+            return queue_status::closed;
+        }
+        item = dequeue_locked();
+        return queue_status::ok;
+    }
+
+    /**
+     * @brief Pop the oldest live item, waiting at most @p timeout for one.
+     *
+     * @return queue_status::ok, queue_status::timeout or queue_status::closed.
+     */
+    queue_status try_pop(T& item, const std::chrono::milliseconds& timeout) {
+        std::unique_lock<std::mutex> lock(mutex_sync);
+        if (!counted_wait_until<Clock>(not_empty, lock, [this]() { return closed_flag || has_live_locked(); },
+                                       Clock::now() + timeout, counters_data, wait_side::consumer)) {
+            return queue_status::timeout;
+        }
+        if (!has_live_locked()) {
+            return queue_status::closed;
+        }
+        item = dequeue_locked();
+        return queue_status::ok;
+    }
+
+    /**
+     * @brief Evict the run of expired items at the head.
+     *
+     * @return size_t The number of items evicted.
+     */
+    size_t purge_expired() {
+        std::lock_guard<std::mutex> lock(mutex_sync);
+        return evict_expired_locked(Clock::now());
+    }
+
+    /**
+     * @brief Close the queue; see safe_queue::close().
+     */
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_sync);
+        closed_flag = true;
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+    /**
+     * @brief Get the number of queued items, including expired ones not yet evicted.
+     */
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_sync);
+        return current_size;
+    }
+
+    /**
+     * @brief Get the activity counters of the queue; see safe_queue::counters().
+     */
+    const queue_counters& counters() const { return counters_data; }
+
+private:
+    struct slot {
+        T item;
+        time_point expires;     ///< time_point::max() if the item never expires
+    };
+
+    bool has_room_locked() {
+        if (current_size < maximum_capacity) {
+            return true;
+        }
+        return evict_expired_locked(Clock::now()) > 0;
+    }
+
+    /**
+     * @brief Wait for room, also waking when the head item expires.
+     *
+     * @param deadline When to give up, or nullptr to wait indefinitely.
+     * @return bool false if the deadline passed first.
+     */
+    bool await_room_locked(std::unique_lock<std::mutex>& lock, const time_point* deadline) {
+        auto ready = [this]() { return closed_flag || has_room_locked(); };
+        if (ready()) {
+            return true;
+        }
+        bool satisfied = true;
+        {
+            counted_wait_scope scope(counters_data, wait_side::producer);
+            while (!ready()) {
+                const time_point expiry = current_size > 0 ? slots[first].expires : time_point::max();
+                if (deadline != nullptr && *deadline <= expiry) {
+                    satisfied = Clock::wait_until(not_full, lock, *deadline, ready);
+                    break;
+                }
+                if (expiry == time_point::max()) {
+                    not_full.wait(lock);
+                } else {
+                    Clock::wait_until(not_full, lock, expiry, ready);
+                }
+            }
+        }
+        if (!satisfied) {
+            bump_counter(counters_data.timeouts);
+        }
+        return satisfied;
+    }
+
+    bool has_live_locked() {
+        if (current_size == 0) {
+            return false;
+        }
+        evict_expired_locked(Clock::now());
+        return current_size > 0;
+    }
+
+    size_t evict_expired_locked(time_point now) {
+        size_t evicted = 0;
+        while (current_size > 0 && slots[first].expires <= now) {
+            slots[first].item = T();
+            first = (first + 1) % maximum_capacity;
+            --current_size;
+            ++evicted;
+        }
+        if (evicted > 0) {
+            bump_counter(counters_data.expired, static_cast<uint64_t>(evicted));
+            counters_data.depth.store(current_size, std::memory_order_relaxed);
+            not_full.notify_all();
+        }
+        return evicted;
+    }
+
+    void enqueue_locked(T&& item, std::chrono::milliseconds ttl) {
+        slot& s = slots[last];
+        s.item = std::move(item);
+        s.expires = ttl.count() > 0 ? Clock::now() + ttl : time_point::max();
+        last = (last + 1) % maximum_capacity;
+        ++current_size;
+        bump_counter(counters_data.pushes);
+        counters_data.depth.store(current_size, std::memory_order_relaxed);
+        not_empty.notify_one();
+    }
+
+    T dequeue_locked() {
+        T item = std::move(slots[first].item);
+        first = (first + 1) % maximum_capacity;
+        --current_size;
+        bump_counter(counters_data.pops);
+        counters_data.depth.store(current_size, std::memory_order_relaxed);
+        not_full.notify_one();
+        return item;
+    }
+
+    slot* slots;                            ///< Ring of items with their expiry
+    const size_t maximum_capacity;          ///< Maximum number of items
+    const std::chrono::milliseconds default_ttl; ///< Time-to-live of items pushed without one
+    size_t current_size = 0;                ///< Items queued, live or expired
+    size_t first = 0;                       ///< Index of the oldest item
+    size_t last = 0;                        ///< Index where the next item goes
+    bool closed_flag = false;               ///< Set once by close()
+    mutable std::mutex mutex_sync;          ///< Guards everything above
+    std::condition_variable not_full;       ///< Signalled when room is made
+    std::condition_variable not_empty;      ///< Signalled when an item is pushed
+    queue_counters counters_data;           ///< Lock-free activity counters
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include "ttl_queue.h"
+
+using std::chrono::milliseconds;
+
+class TtlQueueTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        virtual_clock::reset();
+    }
+
+    void TearDown() override {
+        virtual_clock::reset();
+    }
+
+    ttl_queue<int, virtual_clock> q{4, milliseconds(100)};
+};
+
+TEST_F(TtlQueueTest, PopSkipsExpiredItems) {
+    q.push(1);
+    q.push(2);
+    virtual_clock::advance(milliseconds(60));
+    q.push(3);
+    virtual_clock::advance(milliseconds(60));  // 1 and 2 are now 120ms old
+
+    int val = 0;
+    EXPECT_EQ(q.try_pop(val, milliseconds(10)), queue_status::ok);
+    EXPECT_EQ(val, 3);
+    EXPECT_EQ(q.counters().expired.load(), 2u);
+    EXPECT_EQ(q.counters().pops.load(), 1u);
+}
+
+TEST_F(TtlQueueTest, PurgeStopsAtFirstLiveItem) {
+    q.push(1, milliseconds(10));
+    q.push(2, milliseconds(0));  // never expires
+    q.push(3, milliseconds(10));
+    virtual_clock::advance(milliseconds(20));
+
+    EXPECT_EQ(q.purge_expired(), 1u);
+    EXPECT_EQ(q.size(), 2u);  // 3 waits behind the live 2
+    int val = 0;
+    EXPECT_EQ(q.pop(val), queue_status::ok);
+    EXPECT_EQ(val, 2);
+    EXPECT_EQ(q.try_pop(val, milliseconds(10)), queue_status::timeout);
+    EXPECT_EQ(q.counters().expired.load(), 2u);
+}
+
+TEST_F(TtlQueueTest, ExpiredItemsMakeRoom) {
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(q.push(i), queue_status::ok);
+    }
+    EXPECT_EQ(q.try_push(4, milliseconds(10)), queue_status::timeout);
+    // Waiting on the full queue lets the head expire (virtual time jumps).
+    EXPECT_EQ(q.try_push(4, milliseconds(200)), queue_status::ok);
+    EXPECT_EQ(q.counters().expired.load(), 4u);
+    EXPECT_EQ(q.size(), 1u);
+}
+
+TEST_F(TtlQueueTest, TimedPushTakesItsOwnTtl) {
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(q.push(i, milliseconds(0)), queue_status::ok);
+    }
+    EXPECT_EQ(q.try_push(3, milliseconds(10), milliseconds(5)), queue_status::ok);
+    EXPECT_EQ(q.try_push(4, milliseconds(10), milliseconds(5)), queue_status::timeout);
+    EXPECT_EQ(q.counters().timeouts.load(), 1u);
+    virtual_clock::advance(milliseconds(20));
+    EXPECT_EQ(q.purge_expired(), 0u);  // Item 3 sits behind never-expiring ones
+    
+    int val = 0;
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(q.try_pop(val, milliseconds(0)), queue_status::ok);
+        EXPECT_EQ(val, i);
+    }
+    EXPECT_EQ(q.try_pop(val, milliseconds(0)), queue_status::timeout);
+    EXPECT_EQ(q.counters().expired.load(), 1u);
+}
+
+TEST_F(TtlQueueTest, CloseReportsClosedWhenOnlyExpiredRemain) {
+    q.push(1);
+    q.close();
+    virtual_clock::advance(milliseconds(200));
+    int val = 0;
+    EXPECT_EQ(q.pop(val), queue_status::closed);
+    EXPECT_EQ(q.push(2), queue_status::closed);
+}
+
+TEST(TtlQueueRealClockTest, BlockedProducerWakesWhenHeadExpires) {
+    ttl_queue<int> q(1, milliseconds(20));
+    q.push(1);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(q.push(2), queue_status::ok);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, milliseconds(15));
+    EXPECT_EQ(q.counters().expired.load(), 1u);
+}